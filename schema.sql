@@ -32,6 +32,815 @@ ALTER SCHEMA public OWNER TO neondb_owner;
 COMMENT ON SCHEMA public IS '';
 
 
+--
+-- Name: scoot_log_set_changes(); Type: FUNCTION; Schema: public; Owner: neondb_owner
+--
+
+CREATE FUNCTION public.scoot_log_set_changes() RETURNS trigger
+    LANGUAGE plpgsql
+    AS $$
+DECLARE
+    changed jsonb;
+BEGIN
+    -- Each game set the statement touched moves one version, and the queue entries (by user) and
+    -- games it changed are logged at that version for since= deltas. Moving the version updates
+    -- game_sets, whose row trigger notifies long-lived scootd processes.
+    IF TG_OP = 'INSERT' THEN
+        SELECT jsonb_agg(to_jsonb(r)) INTO changed FROM new_rows r;
+    ELSIF TG_OP = 'DELETE' THEN
+        SELECT jsonb_agg(to_jsonb(r)) INTO changed FROM old_rows r;
+    ELSE
+        SELECT jsonb_agg(to_jsonb(r)) INTO changed
+        FROM (SELECT * FROM new_rows UNION ALL SELECT * FROM old_rows) r;
+    END IF;
+    IF changed IS NULL THEN
+        RETURN NULL;
+    END IF;
+
+    WITH touched AS (
+        SELECT DISTINCT
+            CASE TG_TABLE_NAME WHEN 'checkins' THEN x.game_set_id WHEN 'games' THEN x.set_id ELSE g.set_id END
+                AS set_id,
+            CASE TG_TABLE_NAME WHEN 'checkins' THEN x.user_id END AS user_id,
+            CASE TG_TABLE_NAME WHEN 'games' THEN x.id WHEN 'game_players' THEN x.game_id END AS game_id
+        FROM jsonb_to_recordset(changed)
+             AS x(id integer, set_id integer, game_set_id integer, user_id integer, game_id integer)
+        LEFT JOIN public.games g ON TG_TABLE_NAME = 'game_players' AND g.id = x.game_id
+    ), bumped AS (
+        UPDATE public.game_sets s SET version = s.version + 1
+        WHERE s.id IN (SELECT set_id FROM touched)
+        RETURNING s.id, s.version
+    )
+    INSERT INTO public.game_set_changes (game_set_id, version, user_id, game_id)
+    SELECT b.id, b.version, t.user_id, t.game_id FROM touched t JOIN bumped b ON b.id = t.set_id;
+    RETURN NULL;
+END;
+$$;
+
+
+ALTER FUNCTION public.scoot_log_set_changes() OWNER TO neondb_owner;
+
+--
+-- Name: scoot_notify_set_changed(); Type: FUNCTION; Schema: public; Owner: neondb_owner
+--
+
+CREATE FUNCTION public.scoot_notify_set_changed() RETURNS trigger
+    LANGUAGE plpgsql
+    AS $$
+BEGIN
+    -- Long-lived scootd processes keep each game set in memory and drop it on this notification.
+    -- The payload is the game set id, or 0 when every set may be affected (e.g. a username change).
+    IF TG_TABLE_NAME = 'game_sets' THEN
+        PERFORM pg_notify('scoot_set_changed', COALESCE(NEW.id, OLD.id)::text);
+    ELSE
+        PERFORM pg_notify('scoot_set_changed', '0');
+    END IF;
+    RETURN NULL;
+END;
+$$;
+
+
+ALTER FUNCTION public.scoot_notify_set_changed() OWNER TO neondb_owner;
+
+--
+-- Name: scoot_notify_stats_changed(); Type: FUNCTION; Schema: public; Owner: neondb_owner
+--
+
+CREATE FUNCTION public.scoot_notify_stats_changed() RETURNS trigger
+    LANGUAGE plpgsql
+    AS $$
+DECLARE
+    member record;
+BEGIN
+    -- Long-lived scootd processes keep leaderboards in memory and move the player in the payload;
+    -- deleting or truncating the table (rebuild-stats) makes them drop every board.
+    IF TG_LEVEL = 'STATEMENT' THEN
+        PERFORM pg_notify('scoot_stats_changed', 'reset');
+        RETURN NULL;
+    END IF;
+
+    SELECT u.username, u.birth_year INTO member FROM public.users u WHERE u.id = NEW.user_id;
+    PERFORM pg_notify('scoot_stats_changed', concat_ws(' ',
+        COALESCE((to_jsonb(NEW) ->> 'game_set_id')::integer, 0), NEW.user_id, NEW.games_played, NEW.wins,
+        NEW.losses, NEW.current_streak, NEW.best_streak, COALESCE(member.birth_year, 0),
+        COALESCE(member.username, '')));
+    RETURN NULL;
+END;
+$$;
+
+
+ALTER FUNCTION public.scoot_notify_stats_changed() OWNER TO neondb_owner;
+
+--
+-- Name: scoot_bump_set_version(); Type: FUNCTION; Schema: public; Owner: neondb_owner
+--
+
+CREATE FUNCTION public.scoot_bump_set_version() RETURNS trigger
+    LANGUAGE plpgsql
+    AS $$
+BEGIN
+    -- Direct changes to a game set row (queue positions, settings) move its version too
+    IF NEW.version = OLD.version THEN
+        NEW.version := OLD.version + 1;
+    END IF;
+    RETURN NEW;
+END;
+$$;
+
+
+ALTER FUNCTION public.scoot_bump_set_version() OWNER TO neondb_owner;
+
+--
+-- Name: scoot_team_key(integer[]); Type: FUNCTION; Schema: public; Owner: neondb_owner
+--
+
+CREATE FUNCTION public.scoot_team_key(player_ids integer[]) RETURNS text
+    LANGUAGE sql IMMUTABLE
+    AS $$
+    -- A team's player ids in ascending order, as scootd's ScootTeamKey text
+    SELECT string_agg(id::text, ',' ORDER BY id) FROM unnest(player_ids) AS id;
+$$;
+
+
+ALTER FUNCTION public.scoot_team_key(player_ids integer[]) OWNER TO neondb_owner;
+
+--
+-- Name: scoot_team_hash(integer[]); Type: FUNCTION; Schema: public; Owner: neondb_owner
+--
+
+CREATE FUNCTION public.scoot_team_hash(player_ids integer[]) RETURNS bigint
+    LANGUAGE plpgsql IMMUTABLE
+    AS $$
+DECLARE
+    hash numeric := 14695981039346656037;
+    player_id bigint;
+    low_byte integer;
+BEGIN
+    -- 64-bit FNV-1a of the sorted ids' little-endian bytes, as scootd's ScootTeamKey hash,
+    -- worked in numeric because bigint arithmetic does not wrap
+    FOREACH player_id IN ARRAY ARRAY(SELECT id FROM unnest(player_ids) AS id ORDER BY id) LOOP
+        IF player_id < 0 THEN
+            player_id := player_id + 4294967296;
+        END IF;
+        FOR shift IN 0..3 LOOP
+            low_byte := mod(hash, 256)::integer # ((player_id >> (shift * 8)) & 255)::integer;
+            hash := hash - mod(hash, 256) + low_byte;
+            hash := mod(hash * 1099511628211, 18446744073709551616);
+        END LOOP;
+    END LOOP;
+
+    IF hash >= 9223372036854775808 THEN
+        hash := hash - 18446744073709551616;
+    END IF;
+    RETURN hash::bigint;
+END;
+$$;
+
+
+ALTER FUNCTION public.scoot_team_hash(player_ids integer[]) OWNER TO neondb_owner;
+
+--
+-- Name: scoot_result(text, integer, text[], jsonb); Type: FUNCTION; Schema: public; Owner: neondb_owner
+--
+
+CREATE FUNCTION public.scoot_result(status text, game_set_id integer, messages text[], extra jsonb DEFAULT '{}'::jsonb) RETURNS jsonb
+    LANGUAGE sql IMMUTABLE
+    AS $$
+    -- The document every scoot_* command function returns; an ERROR carries its reason in message
+    SELECT jsonb_build_object('status', status, 'game_set_id', game_set_id,
+                              'message', CASE WHEN status = 'ERROR' THEN messages[1] END,
+                              'messages', to_jsonb(COALESCE(messages, '{}'::text[]))) || extra;
+$$;
+
+
+ALTER FUNCTION public.scoot_result(status text, game_set_id integer, messages text[], extra jsonb) OWNER TO neondb_owner;
+
+--
+-- Name: scoot_queue_respace(integer); Type: FUNCTION; Schema: public; Owner: neondb_owner
+--
+
+CREATE FUNCTION public.scoot_queue_respace(p_set integer) RETURNS integer
+    LANGUAGE plpgsql
+    AS $$
+DECLARE
+    respaced integer;
+BEGIN
+    -- scootd's checkin_rebalance: ranks SCOOT_RANK_GAP (1024) apart in order, allocator after them
+    WITH r AS (
+        UPDATE public.checkins c SET queue_position = r.n * 1024
+        FROM (SELECT id, row_number() OVER (ORDER BY queue_position, id) AS n
+              FROM public.checkins WHERE game_set_id = p_set AND is_active) r
+        WHERE c.id = r.id AND c.is_active
+        RETURNING c.queue_position
+    )
+    SELECT count(*) INTO respaced FROM r;
+
+    UPDATE public.game_sets SET queue_last_rank = respaced * 1024 WHERE id = p_set;
+    RETURN respaced;
+END;
+$$;
+
+
+ALTER FUNCTION public.scoot_queue_respace(p_set integer) OWNER TO neondb_owner;
+
+--
+-- Name: scoot_queue_allocate(integer, integer); Type: FUNCTION; Schema: public; Owner: neondb_owner
+--
+
+CREATE FUNCTION public.scoot_queue_allocate(p_set integer, p_count integer) RETURNS integer
+    LANGUAGE plpgsql
+    AS $$
+DECLARE
+    last_rank integer;
+BEGIN
+    -- scootd's scoot_queue_allocate: the last of p_count ranks reserved after the queue, respacing
+    -- once the ranks would pass SCOOT_RANK_LIMIT (2^30); 0 when the set is not active
+    FOR attempt IN 1..2 LOOP
+        UPDATE public.game_sets gs
+        SET queue_last_rank = GREATEST(gs.queue_last_rank,
+            (SELECT COALESCE(max(c.queue_position), 0) FROM public.checkins c
+             WHERE c.game_set_id = gs.id AND c.is_active)) + p_count * 1024
+        WHERE gs.id = p_set AND gs.is_active
+        RETURNING gs.queue_last_rank INTO last_rank;
+
+        IF NOT FOUND THEN
+            RETURN 0;
+        END IF;
+        IF last_rank <= 1073741824 THEN
+            RETURN last_rank;
+        END IF;
+        PERFORM public.scoot_queue_respace(p_set);
+    END LOOP;
+
+    RAISE EXCEPTION 'Game set % has no room for % more queue ranks', p_set, p_count;
+END;
+$$;
+
+
+ALTER FUNCTION public.scoot_queue_allocate(p_set integer, p_count integer) OWNER TO neondb_owner;
+
+--
+-- Name: scoot_checkin(integer, integer); Type: FUNCTION; Schema: public; Owner: neondb_owner
+--
+
+CREATE FUNCTION public.scoot_checkin(p_set integer, p_user integer) RETURNS jsonb
+    LANGUAGE plpgsql
+    AS $$
+DECLARE
+    game_set public.game_sets%ROWTYPE;
+    player public.users%ROWTYPE;
+    existing_position integer;
+    waiting integer;
+    new_rank integer;
+    new_position integer;
+BEGIN
+    -- Same checks and effects as scootd checkin; the set's row lock orders concurrent arrivals
+    SELECT * INTO game_set FROM public.game_sets WHERE id = p_set FOR UPDATE;
+    IF NOT FOUND THEN
+        RETURN public.scoot_result('ERROR', p_set, ARRAY[format('Game set %s does not exist', p_set)]);
+    END IF;
+    IF NOT game_set.is_active THEN
+        RETURN public.scoot_result('ERROR', p_set, ARRAY[format('Game set %s is not active', p_set)]);
+    END IF;
+
+    SELECT * INTO player FROM public.users WHERE id = p_user;
+    IF NOT FOUND THEN
+        RETURN public.scoot_result('ERROR', p_set, ARRAY[format('User with ID %s does not exist', p_user)]);
+    END IF;
+    IF NOT player.is_player THEN
+        RETURN public.scoot_result('ERROR', p_set, ARRAY['User is not a player (missing is_player permission)']);
+    END IF;
+
+    SELECT queue_position INTO existing_position
+    FROM public.queue_entries WHERE game_set_id = p_set AND user_id = p_user;
+    IF FOUND THEN
+        RETURN public.scoot_result('OK', p_set,
+            ARRAY[format('User %s is already checked in at position %s', player.username, existing_position)]);
+    END IF;
+
+    SELECT count(*), GREATEST(game_set.queue_last_rank, COALESCE(max(queue_position), 0)) + 1024
+    INTO waiting, new_rank
+    FROM public.checkins WHERE game_set_id = p_set AND is_active;
+    IF new_rank > 1073741824 THEN
+        new_rank := (public.scoot_queue_respace(p_set) + 1) * 1024;
+    END IF;
+    new_position := game_set.current_queue_position + waiting;
+
+    INSERT INTO public.checkins
+        (user_id, club_index, check_in_time, is_active, check_in_date, game_set_id, queue_position, type, game_id, team)
+    VALUES (p_user, 34, LOCALTIMESTAMP(0), true, to_char(LOCALTIMESTAMP, 'YYYY-MM-DD'), p_set, new_rank, 'manual', NULL, NULL);
+
+    -- One update of the set for both its allocator and queue_next_up
+    UPDATE public.game_sets SET queue_last_rank = new_rank, queue_next_up = new_position + 1 WHERE id = p_set;
+
+    RETURN public.scoot_result('OK', p_set,
+        ARRAY[format('Player %s successfully checked in to game set %s at position %s', player.username, p_set, new_position)]);
+END;
+$$;
+
+
+ALTER FUNCTION public.scoot_checkin(p_set integer, p_user integer) OWNER TO neondb_owner;
+
+--
+-- Name: scoot_checkout(integer, integer, integer); Type: FUNCTION; Schema: public; Owner: neondb_owner
+--
+
+CREATE FUNCTION public.scoot_checkout(p_set integer, p_position integer, p_user integer) RETURNS jsonb
+    LANGUAGE plpgsql
+    AS $$
+DECLARE
+    entry record;
+    below integer;
+BEGIN
+    SELECT q.id, q.queue_rank, u.username INTO entry
+    FROM public.queue_entries q JOIN public.users u ON u.id = q.user_id
+    WHERE q.game_set_id = p_set AND q.queue_position = p_position AND q.user_id = p_user;
+    IF NOT FOUND THEN
+        RETURN public.scoot_result('ERROR', p_set, ARRAY[format(
+            'No active check-in found for user ID %s at position %s in game set %s', p_user, p_position, p_set)]);
+    END IF;
+
+    SELECT count(*) INTO below FROM public.checkins
+    WHERE game_set_id = p_set AND is_active AND queue_position > entry.queue_rank;
+
+    -- Players below move up one place by themselves; their ranks don't change
+    UPDATE public.checkins SET is_active = false WHERE id = entry.id AND is_active;
+
+    RETURN public.scoot_result('OK', p_set, ARRAY[
+        format('Successfully checked out player %s (ID: %s) from position %s', entry.username, p_user, p_position),
+        format('Adjusted queue positions for %s player(s)', below)]);
+END;
+$$;
+
+
+ALTER FUNCTION public.scoot_checkout(p_set integer, p_position integer, p_user integer) OWNER TO neondb_owner;
+
+--
+-- Name: scoot_bump(integer, integer, integer); Type: FUNCTION; Schema: public; Owner: neondb_owner
+--
+
+CREATE FUNCTION public.scoot_bump(p_set integer, p_position integer, p_user integer) RETURNS jsonb
+    LANGUAGE plpgsql
+    AS $$
+DECLARE
+    entry record;
+    next_entry record;
+BEGIN
+    SELECT q.id, q.queue_rank, u.username INTO entry
+    FROM public.queue_entries q JOIN public.users u ON u.id = q.user_id
+    WHERE q.game_set_id = p_set AND q.queue_position = p_position AND q.user_id = p_user;
+    IF NOT FOUND THEN
+        RETURN public.scoot_result('ERROR', p_set, ARRAY[format(
+            'No player with user ID %s found at position %s in game set %s', p_user, p_position, p_set)]);
+    END IF;
+
+    SELECT q.id, q.user_id, q.queue_position, q.queue_rank, u.username INTO next_entry
+    FROM public.queue_entries q JOIN public.users u ON u.id = q.user_id
+    WHERE q.game_set_id = p_set AND q.queue_rank > entry.queue_rank
+    ORDER BY q.queue_rank
+    LIMIT 1;
+    IF NOT FOUND THEN
+        RETURN public.scoot_result('OK', p_set,
+            ARRAY[format('No player below position %s in the queue to swap with', p_position)]);
+    END IF;
+
+    -- Swap the two ranks; nobody else moves
+    UPDATE public.checkins SET queue_position = next_entry.queue_rank WHERE id = entry.id AND is_active;
+    UPDATE public.checkins SET queue_position = entry.queue_rank WHERE id = next_entry.id AND is_active;
+
+    RETURN public.scoot_result('OK', p_set, ARRAY[format(
+        'Successfully bumped player %s (ID: %s) from position %s to position %s, swapping with %s (ID: %s)',
+        entry.username, p_user, p_position, next_entry.queue_position, next_entry.username, next_entry.user_id)]);
+END;
+$$;
+
+
+ALTER FUNCTION public.scoot_bump(p_set integer, p_position integer, p_user integer) OWNER TO neondb_owner;
+
+--
+-- Name: scoot_bottom(integer, integer, integer); Type: FUNCTION; Schema: public; Owner: neondb_owner
+--
+
+CREATE FUNCTION public.scoot_bottom(p_set integer, p_position integer, p_user integer) RETURNS jsonb
+    LANGUAGE plpgsql
+    AS $$
+DECLARE
+    entry record;
+    below integer;
+    new_rank integer;
+BEGIN
+    PERFORM 1 FROM public.game_sets WHERE id = p_set FOR UPDATE;
+
+    SELECT q.id, q.queue_rank, u.username INTO entry
+    FROM public.queue_entries q JOIN public.users u ON u.id = q.user_id
+    WHERE q.game_set_id = p_set AND q.queue_position = p_position AND q.user_id = p_user;
+    IF NOT FOUND THEN
+        RETURN public.scoot_result('ERROR', p_set, ARRAY[format(
+            'No player with user ID %s found at position %s in game set %s', p_user, p_position, p_set)]);
+    END IF;
+
+    IF NOT EXISTS (SELECT 1 FROM public.game_sets WHERE id = p_set AND is_active) THEN
+        RETURN public.scoot_result('ERROR', p_set, ARRAY[format('No active game set found with ID %s', p_set)]);
+    END IF;
+
+    SELECT count(*) INTO below FROM public.checkins
+    WHERE game_set_id = p_set AND is_active AND queue_position > entry.queue_rank;
+    IF below = 0 THEN
+        RETURN public.scoot_result('OK', p_set, ARRAY[format(
+            'Player %s is already at the bottom of the queue (position %s)', entry.username, p_position)]);
+    END IF;
+
+    -- A rank after the last one; the players after them move up a place by themselves
+    new_rank := public.scoot_queue_allocate(p_set, 1);
+    UPDATE public.checkins SET queue_position = new_rank WHERE id = entry.id AND is_active;
+
+    RETURN public.scoot_result('OK', p_set, ARRAY[
+        format('Successfully moved player %s (ID: %s) from position %s to the bottom (position %s)',
+               entry.username, p_user, p_position, p_position + below),
+        format('Adjusted positions for %s other player(s)', below)]);
+END;
+$$;
+
+
+ALTER FUNCTION public.scoot_bottom(p_set integer, p_position integer, p_user integer) OWNER TO neondb_owner;
+
+--
+-- Name: scoot_new_game(integer, text, boolean); Type: FUNCTION; Schema: public; Owner: neondb_owner
+--
+
+CREATE FUNCTION public.scoot_new_game(p_set integer, p_court text, p_swap boolean) RETURNS jsonb
+    LANGUAGE plpgsql
+    AS $$
+DECLARE
+    game_set public.game_sets%ROWTYPE;
+    busy_game integer;
+    players_per_game integer;
+    player record;
+    checkin_ids integer[] := '{}';
+    user_ids integer[] := '{}';
+    usernames text[] := '{}';
+    positions integer[] := '{}';
+    types text[] := '{}';
+    teams integer[] := '{}';
+    promotion_team integer;
+    home_count integer := 0;
+    away_count integer := 0;
+    team_sizes integer[] := '{0,0}';
+    relative_positions integer[] := '{}';
+    new_game_id integer;
+    birth_years integer[] := '{}';
+    roster jsonb := '[]';
+    n integer;
+BEGIN
+    -- Same team assignment as scootd's propose_game with bCreate
+    SELECT * INTO game_set FROM public.game_sets WHERE id = p_set FOR UPDATE;
+    IF NOT FOUND THEN
+        RETURN public.scoot_result('ERROR', p_set, ARRAY['Game set not found']);
+    END IF;
+
+    SELECT id INTO busy_game FROM public.games
+    WHERE set_id = p_set AND court = p_court AND state IN ('started', 'active')
+    LIMIT 1;
+    IF FOUND THEN
+        RETURN public.scoot_result('ERROR', p_set, ARRAY[format('Game Already in Progress: %s', busy_game)]);
+    END IF;
+
+    players_per_game := game_set.players_per_team * 2;
+
+    FOR player IN
+        SELECT q.id, q.user_id, u.username, u.birth_year, q.queue_position, q.type
+        FROM public.queue_entries q JOIN public.users u ON u.id = q.user_id
+        WHERE q.game_set_id = p_set AND q.game_id IS NULL
+        AND q.queue_position <= game_set.current_queue_position + 8
+        ORDER BY q.queue_rank, q.id
+        LIMIT players_per_game
+    LOOP
+        checkin_ids := checkin_ids || player.id;
+        user_ids := user_ids || player.user_id;
+        usernames := usernames || player.username;
+        birth_years := birth_years || player.birth_year;
+        positions := positions || player.queue_position;
+        types := types || player.type;
+        teams := teams || 0;
+    END LOOP;
+
+    n := COALESCE(array_length(checkin_ids, 1), 0);
+    IF n < players_per_game THEN
+        RETURN public.scoot_result('ERROR', p_set, ARRAY[format('Not Enough players for a game (have: %s)', n)]);
+    END IF;
+
+    -- Promoted players keep the side they were promoted from (the :H or :A suffix) where there is room
+    FOR i IN 1..n LOOP
+        promotion_team := CASE WHEN types[i] NOT LIKE '%promoted%' THEN 0
+                               WHEN types[i] LIKE '%:H' THEN 1
+                               WHEN types[i] LIKE '%:A' THEN 2
+                               ELSE 0 END;
+        IF home_count < game_set.players_per_team AND promotion_team <> 2 THEN
+            teams[i] := 1;
+            home_count := home_count + 1;
+        ELSIF away_count < game_set.players_per_team AND promotion_team <> 1 THEN
+            teams[i] := 2;
+            away_count := away_count + 1;
+        END IF;
+    END LOOP;
+    FOR i IN 1..n LOOP
+        IF teams[i] = 0 AND home_count < game_set.players_per_team THEN
+            teams[i] := 1;
+            home_count := home_count + 1;
+        END IF;
+    END LOOP;
+    FOR i IN 1..n LOOP
+        IF teams[i] = 0 AND away_count < game_set.players_per_team THEN
+            teams[i] := 2;
+            away_count := away_count + 1;
+        END IF;
+    END LOOP;
+
+    IF home_count < game_set.players_per_team THEN
+        RETURN public.scoot_result('ERROR', p_set, ARRAY[format('NOT ENOUGH HOME PLAYERS: %s', home_count)]);
+    END IF;
+    IF away_count < game_set.players_per_team THEN
+        RETURN public.scoot_result('ERROR', p_set, ARRAY[format('NOT ENOUGH AWAY PLAYERS: %s', away_count)]);
+    END IF;
+
+    IF p_swap THEN
+        FOR i IN 1..n LOOP
+            teams[i] := 3 - teams[i];
+        END LOOP;
+    END IF;
+
+    new_game_id := nextval(pg_get_serial_sequence('public.games', 'id'));
+    INSERT INTO public.games (id, set_id, court, team1_score, team2_score, state, start_time,
+                              team1_key, team1_hash, team2_key, team2_hash)
+    SELECT new_game_id, p_set, p_court, 0, 0, 'active', NOW(),
+           public.scoot_team_key(home.ids), public.scoot_team_hash(home.ids),
+           public.scoot_team_key(away.ids), public.scoot_team_hash(away.ids)
+    FROM (SELECT array_agg(user_ids[i]) AS ids FROM generate_subscripts(user_ids, 1) i WHERE teams[i] = 1) home,
+         (SELECT array_agg(user_ids[i]) AS ids FROM generate_subscripts(user_ids, 1) i WHERE teams[i] = 2) away;
+
+    FOR i IN 1..n LOOP
+        team_sizes[teams[i]] := team_sizes[teams[i]] + 1;
+        relative_positions := relative_positions || team_sizes[teams[i]];
+        roster := roster || jsonb_build_object('user_id', user_ids[i], 'username', usernames[i], 'birth_year', birth_years[i],
+                                               'position', positions[i], 'type', types[i], 'team', teams[i]);
+    END LOOP;
+
+    -- Leaving the queue for a game keeps the position the player was shown at
+    UPDATE public.checkins c SET game_id = new_game_id, team = p.team, queue_position = p.position
+    FROM unnest(checkin_ids, teams, positions) AS p(id, team, position)
+    WHERE c.id = p.id AND c.is_active;
+
+    -- NOW() is the transaction start, so the players share the game's start_time and partition
+    INSERT INTO public.game_players (game_id, user_id, team, relative_position, game_start_time)
+    SELECT new_game_id, p.user_id, p.team, p.relative_position, NOW()
+    FROM unnest(user_ids, teams, relative_positions) AS p(user_id, team, relative_position);
+
+    UPDATE public.checkins SET is_active = false WHERE game_id = new_game_id AND is_active;
+    UPDATE public.game_sets SET current_queue_position = current_queue_position + players_per_game WHERE id = p_set;
+
+    -- scootd prints the teams and the new game itself
+    RETURN public.scoot_result('OK', p_set, '{}',
+        jsonb_build_object('game_id', new_game_id, 'court', p_court, 'players', roster));
+END;
+$$;
+
+
+ALTER FUNCTION public.scoot_new_game(p_set integer, p_court text, p_swap boolean) OWNER TO neondb_owner;
+
+--
+-- Name: scoot_end_game(integer, integer, integer, boolean); Type: FUNCTION; Schema: public; Owner: neondb_owner
+--
+
+CREATE FUNCTION public.scoot_end_game(p_game integer, p_home integer, p_away integer, p_autopromote boolean) RETURNS jsonb
+    LANGUAGE plpgsql
+    AS $$
+DECLARE
+    game record;
+    winner integer;
+    loser integer;
+    tie boolean := false;
+    consecutive_games integer := 0;
+    loss_promoted_matches integer := 0;
+    previously_loss_promoted boolean := false;
+    team_to_promote integer;
+    team_with_autoup integer;
+    force_autoup boolean := false;
+    promotion_kind text;
+    first_rank integer;
+    last_rank integer;
+    waiting integer;
+    released integer;
+    next_up integer;
+    promoted_names text[];
+    autoup_names text[];
+    promoted_count integer;
+    autoup_count integer;
+    messages text[] := '{}';
+BEGIN
+    -- Same promotion rules as scootd's end_game
+    IF p_home > p_away THEN
+        winner := 1;
+    ELSIF p_away > p_home THEN
+        winner := 2;
+    ELSE
+        -- In case of a tie, randomly select a team to be "winning" for promotion purposes
+        tie := true;
+        winner := CASE WHEN random() < 0.5 THEN 1 ELSE 2 END;
+    END IF;
+    loser := 3 - winner;
+
+    SELECT g.id, g.set_id, g.state, gs.max_consecutive_games, gs.current_queue_position INTO game
+    FROM public.games g JOIN public.game_sets gs ON gs.id = g.set_id
+    WHERE g.id = p_game
+    FOR UPDATE OF gs;
+    IF NOT FOUND THEN
+        RETURN public.scoot_result('ERROR', NULL, ARRAY[format('Game not found: %s', p_game)]);
+    END IF;
+    IF game.state <> 'active' THEN
+        RETURN public.scoot_result('ERROR', game.set_id,
+            ARRAY[format('Game is not active (current state: %s)', game.state)]);
+    END IF;
+
+    SELECT COALESCE(min(c.queue_position), 0), GREATEST(gs.queue_last_rank, COALESCE(max(c.queue_position), 0)), count(c.id)
+    INTO first_rank, last_rank, waiting
+    FROM public.game_sets gs LEFT JOIN public.checkins c ON c.game_set_id = gs.id AND c.is_active
+    WHERE gs.id = game.set_id
+    GROUP BY gs.id;
+
+    messages := messages || format('Game %s ended with score: %s-%s', p_game, p_home, p_away);
+
+    IF p_autopromote THEN
+        -- Games this exact team has played in the set, win or lose, counting this one
+        SELECT COALESCE(ts.games_played, 0) + 1 INTO consecutive_games
+        FROM public.games g
+        LEFT JOIN public.team_streaks ts ON ts.game_set_id = g.set_id
+             AND ts.team_key = (CASE winner WHEN 1 THEN g.team1_key ELSE g.team2_key END)
+        WHERE g.id = p_game;
+
+        SELECT count(*) INTO loss_promoted_matches
+        FROM public.checkins c JOIN public.game_players gp ON gp.user_id = c.user_id AND gp.game_id = p_game
+        WHERE gp.team = winner AND c.game_set_id = game.set_id AND c.type LIKE 'loss_promoted%' AND c.is_active;
+        previously_loss_promoted := loss_promoted_matches > 0;
+
+        IF previously_loss_promoted THEN
+            team_to_promote := loser;
+            promotion_kind := 'loss_promoted';
+        ELSIF consecutive_games < game.max_consecutive_games THEN
+            team_to_promote := winner;
+            promotion_kind := 'win_promoted';
+        ELSE
+            team_to_promote := loser;
+            promotion_kind := 'loss_promoted';
+        END IF;
+        team_with_autoup := 3 - team_to_promote;
+        force_autoup := previously_loss_promoted AND team_with_autoup = winner;
+
+        SELECT count(*) INTO promoted_count FROM public.game_players WHERE game_id = p_game AND team = team_to_promote;
+        SELECT count(*) INTO autoup_count
+        FROM public.game_players gp JOIN public.users u ON u.id = gp.user_id
+        WHERE gp.game_id = p_game AND gp.team = team_with_autoup AND (force_autoup OR u.autoup);
+
+        IF first_rank - promoted_count * 1024 < -1073741824 OR last_rank + autoup_count * 1024 > 1073741824 THEN
+            messages := messages || format('Respaced queue ranks for %s player(s) in game set %s',
+                                           public.scoot_queue_respace(game.set_id), game.set_id);
+            first_rank := CASE WHEN waiting > 0 THEN 1024 ELSE 0 END;
+            last_rank := waiting * 1024;
+        END IF;
+    END IF;
+
+    UPDATE public.games
+    SET team1_score = p_home, team2_score = p_away, winning_team = winner, state = 'completed', end_time = NOW()
+    WHERE id = p_game;
+
+    INSERT INTO public.team_streaks (game_set_id, team_key, games_played)
+    SELECT g.set_id, t.team_key, 1
+    FROM public.games g CROSS JOIN LATERAL (VALUES (g.team1_key), (g.team2_key)) t(team_key)
+    WHERE g.id = p_game AND t.team_key IS NOT NULL
+    ON CONFLICT (game_set_id, team_key) DO UPDATE SET games_played = team_streaks.games_played + 1;
+
+    INSERT INTO public.player_stats AS ps (user_id, games_played, wins, losses, current_streak, best_streak,
+        points_for, points_against, last_played_at)
+    SELECT gp.user_id, 1, (r.points_for > r.points_against)::integer, (r.points_for < r.points_against)::integer,
+           (r.points_for > r.points_against)::integer, (r.points_for > r.points_against)::integer,
+           r.points_for, r.points_against, g.end_time
+    FROM public.games g
+    JOIN public.game_players gp ON gp.game_id = g.id
+    CROSS JOIN LATERAL (SELECT COALESCE(CASE gp.team WHEN 1 THEN g.team1_score ELSE g.team2_score END, 0),
+                               COALESCE(CASE gp.team WHEN 1 THEN g.team2_score ELSE g.team1_score END, 0))
+         AS r(points_for, points_against)
+    WHERE g.id = p_game
+    ON CONFLICT (user_id) DO UPDATE SET
+        games_played = ps.games_played + 1, wins = ps.wins + EXCLUDED.wins, losses = ps.losses + EXCLUDED.losses,
+        current_streak = (ps.current_streak + 1) * EXCLUDED.wins,
+        best_streak = GREATEST(ps.best_streak, (ps.current_streak + 1) * EXCLUDED.wins),
+        points_for = ps.points_for + EXCLUDED.points_for,
+        points_against = ps.points_against + EXCLUDED.points_against,
+        last_played_at = EXCLUDED.last_played_at;
+
+    INSERT INTO public.game_set_player_stats AS ps (game_set_id, user_id, games_played, wins, losses, current_streak, best_streak,
+        points_for, points_against, last_played_at)
+    SELECT g.set_id, gp.user_id, 1, (r.points_for > r.points_against)::integer, (r.points_for < r.points_against)::integer,
+           (r.points_for > r.points_against)::integer, (r.points_for > r.points_against)::integer,
+           r.points_for, r.points_against, g.end_time
+    FROM public.games g
+    JOIN public.game_players gp ON gp.game_id = g.id
+    CROSS JOIN LATERAL (SELECT COALESCE(CASE gp.team WHEN 1 THEN g.team1_score ELSE g.team2_score END, 0),
+                               COALESCE(CASE gp.team WHEN 1 THEN g.team2_score ELSE g.team1_score END, 0))
+         AS r(points_for, points_against)
+    WHERE g.id = p_game
+    ON CONFLICT (game_set_id, user_id) DO UPDATE SET
+        games_played = ps.games_played + 1, wins = ps.wins + EXCLUDED.wins, losses = ps.losses + EXCLUDED.losses,
+        current_streak = (ps.current_streak + 1) * EXCLUDED.wins,
+        best_streak = GREATEST(ps.best_streak, (ps.current_streak + 1) * EXCLUDED.wins),
+        points_for = ps.points_for + EXCLUDED.points_for,
+        points_against = ps.points_against + EXCLUDED.points_against,
+        last_played_at = EXCLUDED.last_played_at;
+
+    IF NOT p_autopromote THEN
+        RETURN public.scoot_result('OK', game.set_id,
+            messages || 'Autopromote is disabled - no automatic promotions will be performed'::text);
+    END IF;
+
+    IF tie THEN
+        messages := messages || format('Game ended in a tie. Randomly selecting Team %s for promotion logic.', winner);
+    END IF;
+    messages := messages || format('Team has played %s consecutive games (including current)', consecutive_games);
+    IF previously_loss_promoted THEN
+        messages := messages || format('Winning team was previously loss_promoted (found %s matching players)', loss_promoted_matches)
+                             || 'Winning team was previously loss_promoted - now promoting losers'::text;
+    ELSIF team_to_promote = winner THEN
+        messages := messages || format('Team has played %s consecutive games (max: %s) - promoting winners',
+                                       consecutive_games, game.max_consecutive_games);
+    ELSE
+        messages := messages || format('Team has reached max consecutive games (%s) - promoting losers', game.max_consecutive_games);
+    END IF;
+
+    -- Mark all players in the game as inactive in checkins and reset game_id
+    UPDATE public.checkins c SET is_active = false, game_id = NULL
+    FROM public.game_players gp
+    WHERE gp.game_id = p_game AND gp.user_id = c.user_id AND c.game_set_id = game.set_id AND c.is_active;
+    GET DIAGNOSTICS released = ROW_COUNT;
+    messages := messages || format('Deactivated %s player check-ins', released)
+                         || format('Updated %s existing next-up player positions', waiting)
+                         || format('Promoting %s players from team %s:', promoted_count, team_to_promote);
+
+    -- Promoted players take sequential ranks ahead of the first queued player and autoup players
+    -- come after both existing and promoted players, all keeping the side they played on. One insert
+    -- re-queues them and one update moves queue_next_up past them.
+    WITH requeued AS (
+        SELECT gp.user_id, gp.team, u.username, gp.team = team_to_promote AS promoted,
+               row_number() OVER (PARTITION BY gp.team ORDER BY gp.relative_position) - 1 AS n
+        FROM public.game_players gp JOIN public.users u ON u.id = gp.user_id
+        WHERE gp.game_id = p_game
+        AND (gp.team = team_to_promote OR (gp.team = team_with_autoup AND (force_autoup OR u.autoup)))
+    ), inserted AS (
+        INSERT INTO public.checkins (user_id, game_set_id, club_index, queue_position, is_active, type, team, check_in_time, check_in_date)
+        SELECT r.user_id, game.set_id, 34,
+               CASE WHEN r.promoted THEN first_rank - (promoted_count - r.n) * 1024 ELSE last_rank + (r.n + 1) * 1024 END,
+               true,
+               format('%s:%s:%s', CASE WHEN r.promoted THEN promotion_kind ELSE 'autoup' END, consecutive_games,
+                      CASE r.team WHEN 1 THEN 'H' ELSE 'A' END),
+               r.team, NOW(), to_char(NOW(), 'YYYY-MM-DD')
+        FROM requeued r
+        ORDER BY r.promoted DESC, r.n
+        ON CONFLICT DO NOTHING
+    )
+    SELECT array_agg(r.username ORDER BY r.n) FILTER (WHERE r.promoted),
+           array_agg(r.username ORDER BY r.n) FILTER (WHERE NOT r.promoted)
+    INTO promoted_names, autoup_names
+    FROM requeued r;
+
+    UPDATE public.game_sets gs
+    SET queue_next_up = gs.queue_next_up + promoted_count + autoup_count,
+        queue_last_rank = GREATEST(gs.queue_last_rank, last_rank + autoup_count * 1024)
+    WHERE gs.id = game.set_id
+    RETURNING gs.queue_next_up - autoup_count INTO next_up;
+
+    messages := messages || ARRAY(SELECT format('- %s promoted to position %s', p.username, game.current_queue_position + p.n - 1)
+                                  FROM unnest(promoted_names) WITH ORDINALITY AS p(username, n))
+                         || format('Updated queue_next_up to %s after handling win_promoted players', next_up);
+    IF force_autoup THEN
+        messages := messages || 'Auto-checking ALL players from previously loss_promoted winning team'::text;
+    END IF;
+    IF autoup_count > 0 THEN
+        IF force_autoup THEN
+            messages := messages || format('Auto-checking in %s players from winning team (previously loss_promoted):', autoup_count);
+        ELSE
+            messages := messages || format('Auto-checking in %s players with autoup=true:', autoup_count);
+        END IF;
+        messages := messages || format('Using queue_next_up: %s for auto-checking in players', next_up)
+                             || ARRAY(SELECT format('- %s auto-checked in at position %s', p.username, next_up + p.n - 1)
+                                      FROM unnest(autoup_names) WITH ORDINALITY AS p(username, n));
+    END IF;
+
+    RETURN public.scoot_result('OK', game.set_id, messages);
+END;
+$$;
+
+
+ALTER FUNCTION public.scoot_end_game(p_game integer, p_home integer, p_away integer, p_autopromote boolean) OWNER TO neondb_owner;
+
+
 SET default_tablespace = '';
 
 SET default_table_access_method = heap;
@@ -52,11 +861,43 @@ CREATE TABLE public.checkins (
     game_id integer,
     type text DEFAULT 'manual'::text NOT NULL,
     team integer
-);
+)
+PARTITION BY LIST (is_active);
 
 
 ALTER TABLE public.checkins OWNER TO neondb_owner;
 
+--
+-- Name: TABLE checkins; Type: COMMENT; Schema: public; Owner: neondb_owner
+--
+
+COMMENT ON TABLE public.checkins IS 'Queue rows in checkins_active, deactivated rows in checkins_history; an update of is_active moves the row';
+
+--
+-- Name: checkins_active; Type: TABLE; Schema: public; Owner: neondb_owner
+--
+
+CREATE TABLE public.checkins_active PARTITION OF public.checkins FOR VALUES IN (true);
+
+
+ALTER TABLE public.checkins_active OWNER TO neondb_owner;
+
+--
+-- Name: checkins_history; Type: TABLE; Schema: public; Owner: neondb_owner
+--
+
+CREATE TABLE public.checkins_history PARTITION OF public.checkins FOR VALUES IN (false);
+
+
+ALTER TABLE public.checkins_history OWNER TO neondb_owner;
+
+--
+-- Name: COLUMN checkins.queue_position; Type: COMMENT; Schema: public; Owner: neondb_owner
+--
+
+COMMENT ON COLUMN public.checkins.queue_position IS 'Sparse sort key while the checkin is active (see queue_entries for the displayed position); the position the player had when a game took them once inactive';
+
+
 --
 -- Name: checkins_id_seq; Type: SEQUENCE; Schema: public; Owner: neondb_owner
 --
@@ -88,12 +929,29 @@ CREATE TABLE public.game_players (
     game_id integer NOT NULL,
     user_id integer NOT NULL,
     team integer NOT NULL,
-    relative_position integer
-);
+    relative_position integer,
+    game_start_time timestamp without time zone DEFAULT now() NOT NULL
+)
+PARTITION BY RANGE (game_start_time);
 
 
 ALTER TABLE public.game_players OWNER TO neondb_owner;
 
+--
+-- Name: COLUMN game_players.game_start_time; Type: COMMENT; Schema: public; Owner: neondb_owner
+--
+
+COMMENT ON COLUMN public.game_players.game_start_time IS 'The game''s start_time, which places the row in the same month''s partition as its game';
+
+--
+-- Name: game_players_default; Type: TABLE; Schema: public; Owner: neondb_owner
+--
+
+CREATE TABLE public.game_players_default PARTITION OF public.game_players DEFAULT;
+
+
+ALTER TABLE public.game_players_default OWNER TO neondb_owner;
+
 --
 -- Name: game_players_id_seq; Type: SEQUENCE; Schema: public; Owner: neondb_owner
 --
@@ -116,6 +974,47 @@ ALTER SEQUENCE public.game_players_id_seq OWNER TO neondb_owner;
 ALTER SEQUENCE public.game_players_id_seq OWNED BY public.game_players.id;
 
 
+--
+-- Name: game_set_changes; Type: TABLE; Schema: public; Owner: neondb_owner
+--
+
+CREATE TABLE public.game_set_changes (
+    game_set_id integer NOT NULL,
+    version integer NOT NULL,
+    user_id integer,
+    game_id integer
+);
+
+
+ALTER TABLE public.game_set_changes OWNER TO neondb_owner;
+
+--
+-- Name: game_set_player_stats; Type: TABLE; Schema: public; Owner: neondb_owner
+--
+
+CREATE TABLE public.game_set_player_stats (
+    game_set_id integer NOT NULL,
+    user_id integer NOT NULL,
+    games_played integer DEFAULT 0 NOT NULL,
+    wins integer DEFAULT 0 NOT NULL,
+    losses integer DEFAULT 0 NOT NULL,
+    current_streak integer DEFAULT 0 NOT NULL,
+    best_streak integer DEFAULT 0 NOT NULL,
+    points_for integer DEFAULT 0 NOT NULL,
+    points_against integer DEFAULT 0 NOT NULL,
+    last_played_at timestamp without time zone
+);
+
+
+ALTER TABLE public.game_set_player_stats OWNER TO neondb_owner;
+
+--
+-- Name: TABLE game_set_player_stats; Type: COMMENT; Schema: public; Owner: neondb_owner
+--
+
+COMMENT ON TABLE public.game_set_player_stats IS 'player_stats for the games of one game set';
+
+
 --
 -- Name: game_sets; Type: TABLE; Schema: public; Owner: neondb_owner
 --
@@ -133,7 +1032,9 @@ CREATE TABLE public.game_sets (
     is_active boolean DEFAULT true NOT NULL,
     number_of_courts integer DEFAULT 2 NOT NULL,
     current_queue_position integer DEFAULT 1 NOT NULL,
-    queue_next_up integer DEFAULT 1 NOT NULL
+    queue_next_up integer DEFAULT 1 NOT NULL,
+    version integer DEFAULT 0 NOT NULL,
+    queue_last_rank integer DEFAULT 0 NOT NULL
 );
 
 
@@ -174,12 +1075,40 @@ CREATE TABLE public.games (
     team2_score integer,
     club_index integer DEFAULT 34 NOT NULL,
     court text NOT NULL,
-    state text DEFAULT 'started'::text NOT NULL
-);
+    state text DEFAULT 'started'::text NOT NULL,
+    winning_team integer,
+    team1_key text,
+    team1_hash bigint,
+    team2_key text,
+    team2_hash bigint
+)
+PARTITION BY RANGE (start_time);
 
 
 ALTER TABLE public.games OWNER TO neondb_owner;
 
+--
+-- Name: TABLE games; Type: COMMENT; Schema: public; Owner: neondb_owner
+--
+
+COMMENT ON TABLE public.games IS 'One partition per month of start_time (games_pYYYYMM, kept ahead by scootd maintain-partitions); games_default catches the rest';
+
+
+--
+-- Name: COLUMN games.winning_team; Type: COMMENT; Schema: public; Owner: neondb_owner
+--
+
+COMMENT ON COLUMN public.games.winning_team IS 'Team end-game promoted as the winner; a tie is given to a random team, and player stats count it as neither a win nor a loss';
+
+--
+-- Name: games_default; Type: TABLE; Schema: public; Owner: neondb_owner
+--
+
+CREATE TABLE public.games_default PARTITION OF public.games DEFAULT;
+
+
+ALTER TABLE public.games_default OWNER TO neondb_owner;
+
 --
 -- Name: games_id_seq; Type: SEQUENCE; Schema: public; Owner: neondb_owner
 --
@@ -357,6 +1286,65 @@ ALTER SEQUENCE public.moderation_logs_id_seq OWNER TO neondb_owner;
 ALTER SEQUENCE public.moderation_logs_id_seq OWNED BY public.moderation_logs.id;
 
 
+--
+-- Name: player_stats; Type: TABLE; Schema: public; Owner: neondb_owner
+--
+
+CREATE TABLE public.player_stats (
+    user_id integer NOT NULL,
+    games_played integer DEFAULT 0 NOT NULL,
+    wins integer DEFAULT 0 NOT NULL,
+    losses integer DEFAULT 0 NOT NULL,
+    current_streak integer DEFAULT 0 NOT NULL,
+    best_streak integer DEFAULT 0 NOT NULL,
+    points_for integer DEFAULT 0 NOT NULL,
+    points_against integer DEFAULT 0 NOT NULL,
+    last_played_at timestamp without time zone
+);
+
+
+ALTER TABLE public.player_stats OWNER TO neondb_owner;
+
+--
+-- Name: TABLE player_stats; Type: COMMENT; Schema: public; Owner: neondb_owner
+--
+
+COMMENT ON TABLE public.player_stats IS 'Career totals over completed games, added to by end-game and recomputed by scootd rebuild-stats; streaks count consecutive wins. Wins and losses come from the scores, so a tie is neither and ends a streak (games.winning_team only breaks ties for promotion)';
+
+--
+-- Name: queue_entries; Type: VIEW; Schema: public; Owner: neondb_owner
+--
+
+CREATE VIEW public.queue_entries AS
+ SELECT c.id,
+    c.user_id,
+    c.game_set_id,
+    c.game_id,
+    c.type,
+    c.team,
+    c.queue_position AS queue_rank,
+    (((gs.current_queue_position)::bigint + row_number() OVER (PARTITION BY c.game_set_id ORDER BY c.queue_position, c.id)) - 1)::integer AS queue_position
+   FROM (public.checkins c
+     JOIN public.game_sets gs ON ((gs.id = c.game_set_id)))
+  WHERE c.is_active;
+
+
+ALTER VIEW public.queue_entries OWNER TO neondb_owner;
+
+--
+-- Name: scoot_schema_migrations; Type: TABLE; Schema: public; Owner: neondb_owner
+--
+
+CREATE TABLE public.scoot_schema_migrations (
+    version integer NOT NULL,
+    name text NOT NULL,
+    applied_at timestamp without time zone DEFAULT now() NOT NULL
+);
+
+
+ALTER TABLE public.scoot_schema_migrations OWNER TO neondb_owner;
+
+
 --
 -- Name: session; Type: TABLE; Schema: public; Owner: neondb_owner
 --
@@ -370,6 +1358,20 @@ CREATE TABLE public.session (
 
 ALTER TABLE public.session OWNER TO neondb_owner;
 
+--
+-- Name: team_streaks; Type: TABLE; Schema: public; Owner: neondb_owner
+--
+
+CREATE TABLE public.team_streaks (
+    game_set_id integer NOT NULL,
+    team_key text NOT NULL,
+    games_played integer DEFAULT 0 NOT NULL
+);
+
+
+ALTER TABLE public.team_streaks OWNER TO neondb_owner;
+
+
 --
 -- Name: users; Type: TABLE; Schema: public; Owner: neondb_owner
 --
@@ -423,14 +1425,14 @@ ALTER SEQUENCE public.users_id_seq OWNED BY public.users.id;
 -- Name: checkins id; Type: DEFAULT; Schema: public; Owner: neondb_owner
 --
 
-ALTER TABLE ONLY public.checkins ALTER COLUMN id SET DEFAULT nextval('public.checkins_id_seq'::regclass);
+ALTER TABLE public.checkins ALTER COLUMN id SET DEFAULT nextval('public.checkins_id_seq'::regclass);
 
 
 --
 -- Name: game_players id; Type: DEFAULT; Schema: public; Owner: neondb_owner
 --
 
-ALTER TABLE ONLY public.game_players ALTER COLUMN id SET DEFAULT nextval('public.game_players_id_seq'::regclass);
+ALTER TABLE public.game_players ALTER COLUMN id SET DEFAULT nextval('public.game_players_id_seq'::regclass);
 
 
 --
@@ -444,7 +1446,7 @@ ALTER TABLE ONLY public.game_sets ALTER COLUMN id SET DEFAULT nextval('public.ga
 -- Name: games id; Type: DEFAULT; Schema: public; Owner: neondb_owner
 --
 
-ALTER TABLE ONLY public.games ALTER COLUMN id SET DEFAULT nextval('public.games_id_seq'::regclass);
+ALTER TABLE public.games ALTER COLUMN id SET DEFAULT nextval('public.games_id_seq'::regclass);
 
 
 --
@@ -483,19 +1485,35 @@ ALTER TABLE ONLY public.users ALTER COLUMN id SET DEFAULT nextval('public.users_
 
 
 --
--- Name: checkins checkins_pkey; Type: CONSTRAINT; Schema: public; Owner: neondb_owner
+-- Name: checkins_active checkins_active_pkey; Type: CONSTRAINT; Schema: public; Owner: neondb_owner
+--
+
+ALTER TABLE ONLY public.checkins_active
+    ADD CONSTRAINT checkins_active_pkey PRIMARY KEY (id);
+
+
+--
+-- Name: checkins_history checkins_history_pkey; Type: CONSTRAINT; Schema: public; Owner: neondb_owner
 --
 
-ALTER TABLE ONLY public.checkins
-    ADD CONSTRAINT checkins_pkey PRIMARY KEY (id);
+ALTER TABLE ONLY public.checkins_history
+    ADD CONSTRAINT checkins_history_pkey PRIMARY KEY (id);
 
 
 --
--- Name: game_players game_players_pkey; Type: CONSTRAINT; Schema: public; Owner: neondb_owner
+-- Name: game_players_default game_players_default_pkey; Type: CONSTRAINT; Schema: public; Owner: neondb_owner
 --
 
-ALTER TABLE ONLY public.game_players
-    ADD CONSTRAINT game_players_pkey PRIMARY KEY (id);
+ALTER TABLE ONLY public.game_players_default
+    ADD CONSTRAINT game_players_default_pkey PRIMARY KEY (id);
+
+
+--
+-- Name: game_set_player_stats game_set_player_stats_pkey; Type: CONSTRAINT; Schema: public; Owner: neondb_owner
+--
+
+ALTER TABLE ONLY public.game_set_player_stats
+    ADD CONSTRAINT game_set_player_stats_pkey PRIMARY KEY (game_set_id, user_id);
 
 
 --
@@ -507,11 +1525,11 @@ ALTER TABLE ONLY public.game_sets
 
 
 --
--- Name: games games_pkey; Type: CONSTRAINT; Schema: public; Owner: neondb_owner
+-- Name: games_default games_default_pkey; Type: CONSTRAINT; Schema: public; Owner: neondb_owner
 --
 
-ALTER TABLE ONLY public.games
-    ADD CONSTRAINT games_pkey PRIMARY KEY (id);
+ALTER TABLE ONLY public.games_default
+    ADD CONSTRAINT games_default_pkey PRIMARY KEY (id);
 
 
 --
@@ -554,6 +1572,22 @@ ALTER TABLE ONLY public.moderation_logs
     ADD CONSTRAINT moderation_logs_pkey PRIMARY KEY (id);
 
 
+--
+-- Name: player_stats player_stats_pkey; Type: CONSTRAINT; Schema: public; Owner: neondb_owner
+--
+
+ALTER TABLE ONLY public.player_stats
+    ADD CONSTRAINT player_stats_pkey PRIMARY KEY (user_id);
+
+
+--
+-- Name: scoot_schema_migrations scoot_schema_migrations_pkey; Type: CONSTRAINT; Schema: public; Owner: neondb_owner
+--
+
+ALTER TABLE ONLY public.scoot_schema_migrations
+    ADD CONSTRAINT scoot_schema_migrations_pkey PRIMARY KEY (version);
+
+
 --
 -- Name: session session_pkey; Type: CONSTRAINT; Schema: public; Owner: neondb_owner
 --
@@ -562,6 +1596,14 @@ ALTER TABLE ONLY public.session
     ADD CONSTRAINT session_pkey PRIMARY KEY (sid);
 
 
+--
+-- Name: team_streaks team_streaks_pkey; Type: CONSTRAINT; Schema: public; Owner: neondb_owner
+--
+
+ALTER TABLE ONLY public.team_streaks
+    ADD CONSTRAINT team_streaks_pkey PRIMARY KEY (game_set_id, team_key);
+
+
 --
 -- Name: users users_pkey; Type: CONSTRAINT; Schema: public; Owner: neondb_owner
 --
@@ -578,6 +1620,76 @@ ALTER TABLE ONLY public.users
     ADD CONSTRAINT users_username_key UNIQUE (username);
 
 
+--
+-- Name: checkins_active_user_set_idx; Type: INDEX; Schema: public; Owner: neondb_owner
+--
+
+CREATE UNIQUE INDEX checkins_active_user_set_idx ON public.checkins_active USING btree (user_id, game_set_id);
+
+
+--
+-- Name: checkins_game_user_idx; Type: INDEX; Schema: public; Owner: neondb_owner
+--
+
+CREATE INDEX checkins_game_user_idx ON public.checkins USING btree (game_id, user_id) WHERE (game_id IS NOT NULL);
+
+
+--
+-- Name: checkins_set_queue_idx; Type: INDEX; Schema: public; Owner: neondb_owner
+--
+
+CREATE INDEX checkins_set_queue_idx ON public.checkins_active USING btree (game_set_id, queue_position, id);
+
+
+--
+-- Name: game_players_game_team_idx; Type: INDEX; Schema: public; Owner: neondb_owner
+--
+
+CREATE INDEX game_players_game_team_idx ON public.game_players USING btree (game_id, team, relative_position);
+
+
+--
+-- Name: game_players_user_idx; Type: INDEX; Schema: public; Owner: neondb_owner
+--
+
+CREATE INDEX game_players_user_idx ON public.game_players USING btree (user_id);
+
+
+--
+-- Name: game_set_changes_set_version_idx; Type: INDEX; Schema: public; Owner: neondb_owner
+--
+
+CREATE INDEX game_set_changes_set_version_idx ON public.game_set_changes USING btree (game_set_id, version);
+
+
+--
+-- Name: games_set_completed_idx; Type: INDEX; Schema: public; Owner: neondb_owner
+--
+
+CREATE INDEX games_set_completed_idx ON public.games USING btree (set_id, end_time DESC, id DESC) WHERE (state = 'completed'::text);
+
+
+--
+-- Name: games_set_state_court_idx; Type: INDEX; Schema: public; Owner: neondb_owner
+--
+
+CREATE INDEX games_set_state_court_idx ON public.games USING btree (set_id, state, court);
+
+
+--
+-- Name: games_set_team1_hash_idx; Type: INDEX; Schema: public; Owner: neondb_owner
+--
+
+CREATE INDEX games_set_team1_hash_idx ON public.games USING btree (set_id, team1_hash);
+
+
+--
+-- Name: games_set_team2_hash_idx; Type: INDEX; Schema: public; Owner: neondb_owner
+--
+
+CREATE INDEX games_set_team2_hash_idx ON public.games USING btree (set_id, team2_hash);
+
+
 --
 -- Name: idx_session_expire; Type: INDEX; Schema: public; Owner: neondb_owner
 --
@@ -585,6 +1697,153 @@ ALTER TABLE ONLY public.users
 CREATE INDEX idx_session_expire ON public.session USING btree (expire);
 
 
+--
+-- Name: player_stats_best_streak_idx; Type: INDEX; Schema: public; Owner: neondb_owner
+--
+
+CREATE INDEX player_stats_best_streak_idx ON public.player_stats USING btree (best_streak DESC, games_played DESC, user_id);
+
+
+--
+-- Name: player_stats_games_idx; Type: INDEX; Schema: public; Owner: neondb_owner
+--
+
+CREATE INDEX player_stats_games_idx ON public.player_stats USING btree (games_played DESC, user_id);
+
+
+--
+-- Name: player_stats_streak_idx; Type: INDEX; Schema: public; Owner: neondb_owner
+--
+
+CREATE INDEX player_stats_streak_idx ON public.player_stats USING btree (current_streak DESC, games_played DESC, user_id);
+
+
+--
+-- Name: player_stats_win_pct_idx; Type: INDEX; Schema: public; Owner: neondb_owner
+--
+
+CREATE INDEX player_stats_win_pct_idx ON public.player_stats USING btree ((((wins)::numeric / (NULLIF(games_played, 0))::numeric)) DESC NULLS LAST, games_played DESC, user_id);
+
+
+--
+-- Name: player_stats_wins_idx; Type: INDEX; Schema: public; Owner: neondb_owner
+--
+
+CREATE INDEX player_stats_wins_idx ON public.player_stats USING btree (wins DESC, games_played DESC, user_id);
+
+
+--
+-- Name: checkins checkins_scoot_set_deleted; Type: TRIGGER; Schema: public; Owner: neondb_owner
+--
+
+CREATE TRIGGER checkins_scoot_set_deleted AFTER DELETE ON public.checkins REFERENCING OLD TABLE AS old_rows FOR EACH STATEMENT EXECUTE FUNCTION public.scoot_log_set_changes();
+
+
+--
+-- Name: checkins checkins_scoot_set_inserted; Type: TRIGGER; Schema: public; Owner: neondb_owner
+--
+
+CREATE TRIGGER checkins_scoot_set_inserted AFTER INSERT ON public.checkins REFERENCING NEW TABLE AS new_rows FOR EACH STATEMENT EXECUTE FUNCTION public.scoot_log_set_changes();
+
+
+--
+-- Name: checkins checkins_scoot_set_updated; Type: TRIGGER; Schema: public; Owner: neondb_owner
+--
+
+CREATE TRIGGER checkins_scoot_set_updated AFTER UPDATE ON public.checkins REFERENCING NEW TABLE AS new_rows OLD TABLE AS old_rows FOR EACH STATEMENT EXECUTE FUNCTION public.scoot_log_set_changes();
+
+
+--
+-- Name: game_players game_players_scoot_set_deleted; Type: TRIGGER; Schema: public; Owner: neondb_owner
+--
+
+CREATE TRIGGER game_players_scoot_set_deleted AFTER DELETE ON public.game_players REFERENCING OLD TABLE AS old_rows FOR EACH STATEMENT EXECUTE FUNCTION public.scoot_log_set_changes();
+
+
+--
+-- Name: game_players game_players_scoot_set_inserted; Type: TRIGGER; Schema: public; Owner: neondb_owner
+--
+
+CREATE TRIGGER game_players_scoot_set_inserted AFTER INSERT ON public.game_players REFERENCING NEW TABLE AS new_rows FOR EACH STATEMENT EXECUTE FUNCTION public.scoot_log_set_changes();
+
+
+--
+-- Name: game_players game_players_scoot_set_updated; Type: TRIGGER; Schema: public; Owner: neondb_owner
+--
+
+CREATE TRIGGER game_players_scoot_set_updated AFTER UPDATE ON public.game_players REFERENCING NEW TABLE AS new_rows OLD TABLE AS old_rows FOR EACH STATEMENT EXECUTE FUNCTION public.scoot_log_set_changes();
+
+
+--
+-- Name: game_set_player_stats game_set_player_stats_scoot_stats_changed; Type: TRIGGER; Schema: public; Owner: neondb_owner
+--
+
+CREATE TRIGGER game_set_player_stats_scoot_stats_changed AFTER INSERT OR UPDATE ON public.game_set_player_stats FOR EACH ROW EXECUTE FUNCTION public.scoot_notify_stats_changed();
+
+
+--
+-- Name: game_set_player_stats game_set_player_stats_scoot_stats_reset; Type: TRIGGER; Schema: public; Owner: neondb_owner
+--
+
+CREATE TRIGGER game_set_player_stats_scoot_stats_reset AFTER DELETE OR TRUNCATE ON public.game_set_player_stats FOR EACH STATEMENT EXECUTE FUNCTION public.scoot_notify_stats_changed();
+
+
+--
+-- Name: game_sets game_sets_scoot_set_changed; Type: TRIGGER; Schema: public; Owner: neondb_owner
+--
+
+CREATE TRIGGER game_sets_scoot_set_changed AFTER INSERT OR DELETE OR UPDATE ON public.game_sets FOR EACH ROW EXECUTE FUNCTION public.scoot_notify_set_changed();
+
+
+--
+-- Name: game_sets game_sets_scoot_version; Type: TRIGGER; Schema: public; Owner: neondb_owner
+--
+
+CREATE TRIGGER game_sets_scoot_version BEFORE UPDATE ON public.game_sets FOR EACH ROW EXECUTE FUNCTION public.scoot_bump_set_version();
+
+
+--
+-- Name: games games_scoot_set_deleted; Type: TRIGGER; Schema: public; Owner: neondb_owner
+--
+
+CREATE TRIGGER games_scoot_set_deleted AFTER DELETE ON public.games REFERENCING OLD TABLE AS old_rows FOR EACH STATEMENT EXECUTE FUNCTION public.scoot_log_set_changes();
+
+
+--
+-- Name: games games_scoot_set_inserted; Type: TRIGGER; Schema: public; Owner: neondb_owner
+--
+
+CREATE TRIGGER games_scoot_set_inserted AFTER INSERT ON public.games REFERENCING NEW TABLE AS new_rows FOR EACH STATEMENT EXECUTE FUNCTION public.scoot_log_set_changes();
+
+
+--
+-- Name: games games_scoot_set_updated; Type: TRIGGER; Schema: public; Owner: neondb_owner
+--
+
+CREATE TRIGGER games_scoot_set_updated AFTER UPDATE ON public.games REFERENCING NEW TABLE AS new_rows OLD TABLE AS old_rows FOR EACH STATEMENT EXECUTE FUNCTION public.scoot_log_set_changes();
+
+
+--
+-- Name: player_stats player_stats_scoot_stats_changed; Type: TRIGGER; Schema: public; Owner: neondb_owner
+--
+
+CREATE TRIGGER player_stats_scoot_stats_changed AFTER INSERT OR UPDATE ON public.player_stats FOR EACH ROW EXECUTE FUNCTION public.scoot_notify_stats_changed();
+
+
+--
+-- Name: player_stats player_stats_scoot_stats_reset; Type: TRIGGER; Schema: public; Owner: neondb_owner
+--
+
+CREATE TRIGGER player_stats_scoot_stats_reset AFTER DELETE OR TRUNCATE ON public.player_stats FOR EACH STATEMENT EXECUTE FUNCTION public.scoot_notify_stats_changed();
+
+
+--
+-- Name: users users_scoot_set_changed; Type: TRIGGER; Schema: public; Owner: neondb_owner
+--
+
+CREATE TRIGGER users_scoot_set_changed AFTER DELETE OR UPDATE OF username, birth_year, autoup ON public.users FOR EACH ROW EXECUTE FUNCTION public.scoot_notify_set_changed();
+
+
 --
 -- Name: media_attachments fk_media_attachments_user; Type: FK CONSTRAINT; Schema: public; Owner: neondb_owner
 --
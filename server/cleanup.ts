@@ -1,5 +1,6 @@
 /**
  * Database cleanup utility to fix duplicate player check-ins
+ * Run it once before creating checkins_active_user_set_idx; the index keeps new duplicates out.
  */
 import { eq, inArray, and, isNull } from "drizzle-orm";
 import { db } from "./db";
@@ -14,6 +14,8 @@ import { promisify } from 'util';
 import { WebSocketServer } from 'ws';
 import { randomBytes, scrypt } from 'crypto';
 import { setupChatWebSocket, registerChatRoutes } from './chat';
+import { scootdCoprocess } from './scootd-coprocess';
+import { ScootdSocket } from './scootd-socket';
 
 const execAsync = promisify(exec);
 
@@ -58,17 +60,80 @@ function extractAndParseJson(str: string): any | null {
   }
 }
 
+// When a scootd daemon is running (`scootd serve --socket <path>`), send commands straight to its socket
+// so each call reuses the daemon's open database connection instead of starting a process and connecting
+const SCOOTD_SOCKET = process.env.SCOOTD_SOCKET;
+const scootdSocket = SCOOTD_SOCKET ? new ScootdSocket(SCOOTD_SOCKET) : null;
+
+// With SCOOTD_STDIO=1 a single `scootd --stdio` child is kept alive and commands are pipelined over
+// its stdin/stdout; JSON output comes back already separated from the progress chatter
+const SCOOTD_STDIO = process.env.SCOOTD_STDIO === '1';
+
+/**
+ * Parses the JSON a scootd command printed
+ * Coprocess output is exactly one JSON document; one-shot output may have text mixed in
+ */
+function parseScootdOutput(output: string): any | null {
+  if (SCOOTD_STDIO) {
+    try {
+      return JSON.parse(output);
+    } catch (error) {
+      return null;
+    }
+  }
+  return extractAndParseJson(output);
+}
+
+/**
+ * Runs a scootd command on the coprocess
+ * @returns The command's JSON output re-serialized, or its text output
+ */
+async function executeScootdCoprocess(command: string): Promise<string> {
+  console.log(`🔵 EXECUTING (stdio): scootd ${command}`);
+  
+  const response = await scootdCoprocess.request(command.trim().split(/\s+/));
+  
+  if (response.error) {
+    console.error(`🔴 SCOOTD ERROR OUTPUT: ${response.error}`);
+  }
+  if (response.status !== 0) {
+    throw new Error(`scootd ${command} failed with status ${response.status}: ${response.error ?? ''}`);
+  }
+  
+  return response.data !== undefined ? JSON.stringify(response.data) : (response.output ?? '');
+}
+
+/**
+ * Runs a scootd command on the daemon's socket
+ * @returns The command's stdout and stderr, as a one-shot process would have printed them
+ */
+async function executeScootdSocket(socket: ScootdSocket, command: string): Promise<{ stdout: string; stderr: string }> {
+  const reply = await socket.request(command.trim().split(/\s+/));
+  
+  if (reply.status !== 0) {
+    throw new Error(`scootd ${command} failed with status ${reply.status}: ${reply.stderr}`);
+  }
+  
+  return { stdout: reply.stdout, stderr: reply.stderr };
+}
+
 /**
  * Executes a scootd command and returns the result
  * @param command The scootd command to execute
  * @returns The command output (stdout)
  */
 async function executeScootd(command: string): Promise<string> {
+  if (SCOOTD_STDIO) {
+    return executeScootdCoprocess(command);
+  }
+  
   try {
     console.log(`\n===== SCOOTD COMMAND EXECUTION =====`);
-    console.log(`🔵 EXECUTING: ./scootd ${command}`);
+    console.log(`🔵 EXECUTING${scootdSocket ? ` (${SCOOTD_SOCKET})` : ''}: ./scootd ${command}`);
     
-    const { stdout, stderr } = await execAsync(`./scootd ${command}`);
+    const { stdout, stderr } = scootdSocket
+      ? await executeScootdSocket(scootdSocket, command)
+      : await execAsync(`./scootd ${command}`);
     
     if (stderr) {
       console.error(`🔴 SCOOTD ERROR OUTPUT: ${stderr}`);
@@ -702,7 +767,7 @@ export async function registerRoutes(app: Express): Promise<Server> {
       const output = await executeScootd(`game-set-status ${activeGameSet.id} json`);
       
       // Extract and parse JSON using our helper function
-      const data = extractAndParseJson(output);
+      const data = parseScootdOutput(output);
       
       if (data) {
         return res.json(data);
@@ -726,7 +791,7 @@ export async function registerRoutes(app: Express): Promise<Server> {
       const output = await executeScootd(`game-set-status ${gameSetId} json`);
       
       // Extract and parse JSON using our helper function
-      const data = extractAndParseJson(output);
+      const data = parseScootdOutput(output);
       
       if (data) {
         return res.json(data);
@@ -761,7 +826,7 @@ export async function registerRoutes(app: Express): Promise<Server> {
       const output = await executeScootd(`game-set-status ${gameSetId} json`);
       
       // Extract and parse JSON using our helper function
-      const data = extractAndParseJson(output);
+      const data = parseScootdOutput(output);
       
       if (data) {
         return res.json(data);
@@ -1017,7 +1082,7 @@ export async function registerRoutes(app: Express): Promise<Server> {
       const output = await executeScootd(`propose-game ${gameSetId} ${court} json ${swapParam}`);
       
       // Extract and parse JSON using our helper function
-      const data = extractAndParseJson(output);
+      const data = parseScootdOutput(output);
       
       if (!data) {
         console.error('POST /api/scootd/propose-game - Error parsing JSON');
@@ -1028,7 +1093,7 @@ export async function registerRoutes(app: Express): Promise<Server> {
       if (data.team1 && Array.isArray(data.team1)) {
         // Find win/loss promoted players from game-set-status
         const gameSetStatusOutput = await executeScootd(`game-set-status ${data.game_set_id} json`);
-        const gameSetStatus = extractAndParseJson(gameSetStatusOutput);
+        const gameSetStatus = parseScootdOutput(gameSetStatusOutput);
         
         if (gameSetStatus && gameSetStatus.next_up_players) {
           // Map user_ids to their checkin_types
@@ -1082,7 +1147,7 @@ export async function registerRoutes(app: Express): Promise<Server> {
       const output = await executeScootd(`new-game ${gameSetId} ${court} json ${swapParam}`);
       
       // Extract and parse JSON using our helper function
-      const data = extractAndParseJson(output);
+      const data = parseScootdOutput(output);
       
       if (!data) {
         console.error('POST /api/scootd/new-game - Error parsing JSON');
@@ -1093,7 +1158,7 @@ export async function registerRoutes(app: Express): Promise<Server> {
       if (data.team1 && Array.isArray(data.team1)) {
         // Find win/loss promoted players from game-set-status
         const gameSetStatusOutput = await executeScootd(`game-set-status ${data.game_set_id} json`);
-        const gameSetStatus = extractAndParseJson(gameSetStatusOutput);
+        const gameSetStatus = parseScootdOutput(gameSetStatusOutput);
         
         if (gameSetStatus && gameSetStatus.next_up_players) {
           // Map user_ids to their checkin_types
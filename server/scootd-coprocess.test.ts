@@ -0,0 +1,117 @@
+import { EventEmitter } from 'events';
+import { PassThrough } from 'stream';
+import { spawn } from 'child_process';
+import { scootdCoprocess, type ScootdResponse } from './scootd-coprocess';
+
+jest.mock('child_process', () => ({ spawn: jest.fn() }));
+
+/**
+ * Test suite for the scootd --stdio coprocess client
+ * A fake child stands in for scootd so responses can be sent back in any order
+ */
+
+class FakeScootd extends EventEmitter {
+  stdin = new PassThrough();
+  stdout = new PassThrough();
+  stderr = new PassThrough();
+  requests: { id: number; args: string[] }[] = [];
+
+  constructor() {
+    super();
+    let buffered = '';
+    this.stdin.on('data', (chunk) => {
+      buffered += chunk.toString();
+      const lines = buffered.split('\n');
+      buffered = lines.pop()!;
+      lines.forEach((line) => this.requests.push(JSON.parse(line)));
+    });
+  }
+
+  respond(response: ScootdResponse) {
+    this.stdout.write(JSON.stringify(response) + '\n');
+  }
+}
+
+const flush = () => new Promise((resolve) => setImmediate(resolve));
+
+describe('scootd Coprocess', () => {
+  const fakes: FakeScootd[] = [];
+
+  beforeAll(() => {
+    jest.spyOn(console, 'error').mockImplementation(() => {});
+    (spawn as jest.Mock).mockImplementation(() => {
+      const fake = new FakeScootd();
+      fakes.push(fake);
+      return fake;
+    });
+  });
+
+  test('matches interleaved responses to their requests', async () => {
+    const commands = [
+      ['game-set-status', '1', 'json'],
+      ['checkin', '1', '42', 'json'],
+      ['leaderboard', '1', 'json'],
+      ['checkout', '1', '42', 'json']
+    ];
+    const responses = commands.map((args) => scootdCoprocess.request(args));
+    await flush();
+
+    const fake = fakes[fakes.length - 1];
+    expect(spawn).toHaveBeenCalledTimes(1);
+    expect(fake.requests.map((request) => request.args)).toEqual(commands);
+    expect(new Set(fake.requests.map((request) => request.id)).size).toBe(commands.length);
+
+    // Answer out of order, each response naming the command it belongs to
+    [2, 0, 3, 1].forEach((i) => {
+      const request = fake.requests[i];
+      fake.respond({ id: request.id, status: 0, data: { command: request.args[0] } });
+    });
+
+    const results = await Promise.all(responses);
+    results.forEach((result, i) => {
+      expect(result.id).toBe(fake.requests[i].id);
+      expect(result.data.command).toBe(commands[i][0]);
+    });
+  });
+
+  test('keeps waiting past responses for unknown ids', async () => {
+    const response = scootdCoprocess.request(['queue', '1', 'json']);
+    await flush();
+
+    const fake = fakes[fakes.length - 1];
+    const request = fake.requests[fake.requests.length - 1];
+    fake.respond({ id: request.id + 1000, status: 0, data: { command: 'stray' } });
+    fake.stdout.write('not json\n');
+    fake.respond({ id: request.id, status: 1, error: 'no such game set' });
+
+    const result = await response;
+    expect(result.id).toBe(request.id);
+    expect(result.status).toBe(1);
+    expect(result.error).toBe('no such game set');
+  });
+
+  test('rejects requests in flight when scootd exits and restarts on the next one', async () => {
+    const inFlight = [
+      scootdCoprocess.request(['game-set-status', '1', 'json']),
+      scootdCoprocess.request(['leaderboard', '1', 'json'])
+    ];
+    await flush();
+
+    const exited = fakes[fakes.length - 1];
+    exited.emit('exit', 1, null);
+    for (const request of inFlight) {
+      await expect(request).rejects.toThrow('scootd coprocess exited with code 1');
+    }
+
+    const response = scootdCoprocess.request(['game-set-status', '1', 'json']);
+    await flush();
+
+    const restarted = fakes[fakes.length - 1];
+    expect(restarted).not.toBe(exited);
+    expect(spawn).toHaveBeenCalledTimes(2);
+
+    const request = restarted.requests[0];
+    restarted.respond({ id: request.id, status: 0, data: { command: request.args[0] } });
+    expect((await response).data.command).toBe('game-set-status');
+  });
+});
@@ -0,0 +1,97 @@
+import { spawn, type ChildProcessWithoutNullStreams } from 'child_process';
+import { createInterface } from 'readline';
+
+/**
+ * One response line from `scootd --stdio`
+ * data is set when the command printed a single JSON document, output otherwise
+ */
+export interface ScootdResponse {
+  id: number;
+  status: number;
+  data?: any;
+  output?: string;
+  error?: string;
+}
+
+interface PendingRequest {
+  resolve: (response: ScootdResponse) => void;
+  reject: (error: Error) => void;
+}
+
+/**
+ * Keeps a single `scootd --stdio` child alive and multiplexes requests over its stdin/stdout.
+ * Requests are written as soon as they are made; responses are matched back to callers by id,
+ * so any number of requests can be in flight at once.
+ */
+class ScootdCoprocess {
+  private child: ChildProcessWithoutNullStreams | null = null;
+  private pending = new Map<number, PendingRequest>();
+  private nextId = 1;
+
+  private start(): ChildProcessWithoutNullStreams {
+    const child = spawn('./scootd', ['--stdio']);
+
+    createInterface({ input: child.stdout }).on('line', (line) => {
+      let response: ScootdResponse;
+      try {
+        response = JSON.parse(line);
+      } catch (error) {
+        console.error(`🔴 SCOOTD COPROCESS: unparseable response: ${line}`);
+        return;
+      }
+
+      const request = this.pending.get(response.id);
+      if (!request) {
+        console.error(`🔴 SCOOTD COPROCESS: response for unknown request ${response.id}`);
+        return;
+      }
+      this.pending.delete(response.id);
+      request.resolve(response);
+    });
+
+    // Progress chatter and connection errors
+    createInterface({ input: child.stderr }).on('line', (line) => {
+      console.log(`[scootd] ${line}`);
+    });
+
+    child.on('exit', (code, signal) => {
+      console.error(`🔴 SCOOTD COPROCESS exited (code ${code}, signal ${signal})`);
+      if (this.child === child) {
+        this.child = null;
+      }
+      const error = new Error(`scootd coprocess exited with code ${code}`);
+      this.pending.forEach((request) => request.reject(error));
+      this.pending.clear();
+    });
+
+    child.on('error', (error) => {
+      console.error(`🔴 SCOOTD COPROCESS error:`, error);
+    });
+
+    return child;
+  }
+
+  /**
+   * Send one command and wait for its response
+   * @param args The command line, e.g. ['checkin', '3', '42', 'json']
+   */
+  request(args: string[]): Promise<ScootdResponse> {
+    if (!this.child) {
+      this.child = this.start();
+    }
+
+    const id = this.nextId++;
+    const child = this.child;
+
+    return new Promise((resolve, reject) => {
+      this.pending.set(id, { resolve, reject });
+      child.stdin.write(JSON.stringify({ id, args }) + '\n', (error) => {
+        if (error && this.pending.delete(id)) {
+          reject(error);
+        }
+      });
+    });
+  }
+}
+
+export const scootdCoprocess = new ScootdCoprocess();
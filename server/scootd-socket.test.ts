@@ -0,0 +1,111 @@
+import { createServer, type Server, type Socket } from 'net';
+import { mkdtempSync } from 'fs';
+import { tmpdir } from 'os';
+import { join } from 'path';
+import { ScootdSocket } from './scootd-socket';
+
+/**
+ * Test suite for the scootd serve --socket client
+ * A fake daemon on a temporary socket decodes the request frames and writes replies in pieces
+ */
+
+class FakeDaemon {
+  server: Server;
+  clients: Socket[] = [];
+  requests: string[][] = [];
+
+  constructor(readonly path: string) {
+    this.server = createServer((client) => {
+      this.clients.push(client);
+      let buffered = Buffer.alloc(0);
+      client.on('data', (chunk) => {
+        buffered = Buffer.concat([buffered, chunk]);
+        while (buffered.length >= 4 && buffered.length >= 4 + buffered.readUInt32BE(0)) {
+          const payload = buffered.toString('utf8', 4, 4 + buffered.readUInt32BE(0));
+          buffered = buffered.subarray(4 + buffered.readUInt32BE(0));
+          this.requests.push(payload.split('\0').slice(0, -1));
+        }
+      });
+    });
+  }
+
+  listen(): Promise<void> {
+    return new Promise((resolve) => this.server.listen(this.path, resolve));
+  }
+
+  close(): Promise<void> {
+    this.clients.forEach((client) => client.destroy());
+    return new Promise((resolve) => this.server.close(() => resolve()));
+  }
+
+  reply(status: number, stdout: string, stderr = ''): Buffer {
+    const header = Buffer.alloc(12);
+    header.writeInt32BE(status, 0);
+    header.writeUInt32BE(Buffer.byteLength(stdout), 4);
+    header.writeUInt32BE(Buffer.byteLength(stderr), 8);
+    return Buffer.concat([header, Buffer.from(stdout), Buffer.from(stderr)]);
+  }
+}
+
+const waitFor = async (condition: () => boolean) => {
+  while (!condition()) {
+    await new Promise((resolve) => setTimeout(resolve, 5));
+  }
+};
+
+describe('scootd Socket', () => {
+  let daemon: FakeDaemon;
+
+  beforeEach(async () => {
+    jest.spyOn(console, 'error').mockImplementation(() => {});
+    daemon = new FakeDaemon(join(mkdtempSync(join(tmpdir(), 'scootd-')), 'scootd.sock'));
+    await daemon.listen();
+  });
+
+  afterEach(() => daemon.close());
+
+  test('frames arguments and matches replies in order, even when split across writes', async () => {
+    const socket = new ScootdSocket(daemon.path);
+    const commands = [
+      ['game-set-status', '1', 'json'],
+      ['checkin', '1', '42', 'json'],
+      ['leaderboard', '1', 'wins', '10', 'json']
+    ];
+    const replies = commands.map((args) => socket.request(args));
+    await waitFor(() => daemon.requests.length === commands.length);
+
+    expect(daemon.clients.length).toBe(1);
+    expect(daemon.requests).toEqual(commands);
+
+    const wire = Buffer.concat([
+      daemon.reply(0, '{"command":"game-set-status"}'),
+      daemon.reply(1, '', 'no such game set\n'),
+      daemon.reply(0, 'Leaderboard ✓\n{"command":"leaderboard"}')
+    ]);
+    // One byte at a time, so headers and bodies arrive in pieces
+    for (let i = 0; i < wire.length; i++) {
+      daemon.clients[0].write(wire.subarray(i, i + 1));
+    }
+
+    const results = await Promise.all(replies);
+    expect(results[0]).toEqual({ status: 0, stdout: '{"command":"game-set-status"}', stderr: '' });
+    expect(results[1]).toEqual({ status: 1, stdout: '', stderr: 'no such game set\n' });
+    expect(results[2].stdout).toBe('Leaderboard ✓\n{"command":"leaderboard"}');
+  });
+
+  test('rejects requests in flight when the daemon drops the connection and reconnects on the next one', async () => {
+    const socket = new ScootdSocket(daemon.path);
+    const inFlight = socket.request(['game-set-status', '1', 'json']);
+    await waitFor(() => daemon.requests.length === 1);
+
+    daemon.clients[0].destroy();
+    await expect(inFlight).rejects.toThrow(`scootd at ${daemon.path} closed the connection`);
+
+    const reply = socket.request(['queue', '1', 'json']);
+    await waitFor(() => daemon.requests.length === 2);
+
+    expect(daemon.clients.length).toBe(2);
+    daemon.clients[1].write(daemon.reply(0, '[]'));
+    expect((await reply).stdout).toBe('[]');
+  });
+});
@@ -0,0 +1,103 @@
+import { createConnection, type Socket } from 'net';
+
+/**
+ * One reply from `scootd serve`
+ * status is the exit code the command would have returned as a one-shot process
+ */
+export interface ScootdReply {
+  status: number;
+  stdout: string;
+  stderr: string;
+}
+
+interface PendingRequest {
+  resolve: (reply: ScootdReply) => void;
+  reject: (error: Error) => void;
+}
+
+// int32 status | uint32 stdout length | uint32 stderr length, in network byte order
+const REPLY_HEADER_BYTES = 12;
+
+/**
+ * Keeps one connection to a `scootd serve --socket <path>` daemon and sends it length-framed requests.
+ * The daemon answers the requests on a connection in the order it received them, so replies are
+ * matched to callers first in, first out and any number of requests can be in flight at once.
+ */
+export class ScootdSocket {
+  private socket: Socket | null = null;
+  private pending: PendingRequest[] = [];
+  private buffered = Buffer.alloc(0);
+
+  constructor(private readonly path: string) {}
+
+  private connect(): Socket {
+    const socket = createConnection(this.path);
+
+    socket.on('data', (chunk) => {
+      this.buffered = Buffer.concat([this.buffered, chunk]);
+
+      while (this.buffered.length >= REPLY_HEADER_BYTES) {
+        const stdoutLength = this.buffered.readUInt32BE(4);
+        const stderrLength = this.buffered.readUInt32BE(8);
+        const end = REPLY_HEADER_BYTES + stdoutLength + stderrLength;
+        if (this.buffered.length < end) {
+          break;
+        }
+
+        const reply: ScootdReply = {
+          status: this.buffered.readInt32BE(0),
+          stdout: this.buffered.toString('utf8', REPLY_HEADER_BYTES, REPLY_HEADER_BYTES + stdoutLength),
+          stderr: this.buffered.toString('utf8', REPLY_HEADER_BYTES + stdoutLength, end)
+        };
+        this.buffered = this.buffered.subarray(end);
+
+        const request = this.pending.shift();
+        if (!request) {
+          console.error(`🔴 SCOOTD SOCKET: reply with no request waiting for it`);
+          continue;
+        }
+        request.resolve(reply);
+      }
+    });
+
+    socket.on('error', (error) => {
+      console.error(`🔴 SCOOTD SOCKET error on ${this.path}:`, error);
+    });
+
+    // The daemon drops clients that send a malformed frame; a restarted daemon gets a new connection
+    socket.on('close', () => {
+      if (this.socket === socket) {
+        this.socket = null;
+        this.buffered = Buffer.alloc(0);
+      }
+      const error = new Error(`scootd at ${this.path} closed the connection`);
+      this.pending.forEach((request) => request.reject(error));
+      this.pending = [];
+    });
+
+    return socket;
+  }
+
+  /**
+   * Send one command and wait for its reply
+   * @param args The command line, e.g. ['checkin', '3', '42', 'json']
+   */
+  request(args: string[]): Promise<ScootdReply> {
+    if (!this.socket) {
+      this.socket = this.connect();
+    }
+
+    // Each argument NUL-terminated, behind the payload length
+    const payload = Buffer.concat(args.map((arg) => Buffer.from(`${arg}\0`, 'utf8')));
+    const frame = Buffer.alloc(4 + payload.length);
+    frame.writeUInt32BE(payload.length, 0);
+    payload.copy(frame, 4);
+
+    const socket = this.socket;
+
+    return new Promise((resolve, reject) => {
+      this.pending.push({ resolve, reject });
+      socket.write(frame);
+    });
+  }
+}
@@ -10,6 +10,9 @@ import {
   games,
   gamePlayers,
   gameSets,
+  queueEntries,
+  QUEUE_RANK_GAP,
+  QUEUE_RANK_LIMIT,
   insertUserSchema,
   InsertUser,
   User,
@@ -110,10 +113,9 @@ export class DatabaseStorage implements IStorage {
 
     console.log('getCheckins - Active game set:', { id: activeGameSet.id, currentQueuePosition: activeGameSet.currentQueuePosition });
 
-    // Query for two types of checkins:
-    // 1. Regular active checkins associated with the current game set
-    // 2. Any win_promoted/loss_promoted checkins that might still be inactive
-    //    but should be displayed in the NEXT UP list
+    // Active checkins of the current game set, with the positions queue_entries shows for their ranks.
+    // Promoted players are re-queued as new active checkins when their game ends, so every player in
+    // the NEXT UP list is among them.
     const result = await db
       .select({
         id: checkins.id,
@@ -123,37 +125,22 @@ export class DatabaseStorage implements IStorage {
         isActive: checkins.isActive,
         gameSetId: checkins.gameSetId,
         clubIndex: checkins.clubIndex,
-        queuePosition: checkins.queuePosition,
+        queuePosition: queueEntries.queuePosition,
         gameId: checkins.gameId,
         type: checkins.type,
         team: checkins.team,
         username: users.username,
       })
-      .from(checkins)
+      .from(queueEntries)
+      .innerJoin(checkins, and(eq(checkins.id, queueEntries.id), eq(checkins.isActive, true)))
       .innerJoin(users, eq(checkins.userId, users.id))
       .where(
         and(
           eq(checkins.clubIndex, clubIndex),
-          eq(checkins.gameSetId, activeGameSet.id), // Filter by current active game set
-          or(
-            // Regular active checkins
-            eq(checkins.isActive, true),
-            
-            // Win/loss promoted players that are inactive but should be displayed
-            and(
-              eq(checkins.isActive, false),
-              isNull(checkins.gameId),
-              or(
-                eq(checkins.type, 'win_promoted'),
-                eq(checkins.type, 'loss_promoted')
-              ),
-              // Only include those with positions >= currentQueuePosition (Next Up positions)
-              gte(checkins.queuePosition, activeGameSet.currentQueuePosition)
-            )
-          )
+          eq(queueEntries.gameSetId, activeGameSet.id) // Filter by current active game set
         )
       )
-      .orderBy(asc(checkins.queuePosition));
+      .orderBy(asc(queueEntries.queuePosition));
     
     console.log('getCheckins - Found checkins:', result);
     return result;
@@ -166,63 +153,67 @@ export class DatabaseStorage implements IStorage {
       .where(eq(checkins.id, checkinId));
   }
 
-  async createGame(setId: number, court: string, state: string): Promise<Game> {
-    // Get the game set to access playersPerTeam for updating currentQueuePosition and other settings
-    const [gameSet] = await db.select().from(gameSets).where(eq(gameSets.id, setId));
-    if (!gameSet) throw new Error(`Game set ${setId} not found`);
-    
-    // We need to know what the highest queue position is currently in use
-    // This includes players in active games and waiting in NEXT UP
-    const [highestOverallPosition] = await db
-      .select({ maxPosition: sql`MAX(${checkins.queuePosition})` })
-      .from(checkins)
-      .where(
-        and(
-          eq(checkins.gameSetId, setId),
-          eq(checkins.isActive, true)
-        )
-      );
-    
-    // Find the highest queue position in the NEXT UP list specifically
-    const [highestNextUpPosition] = await db
-      .select({ maxPosition: sql`MAX(${checkins.queuePosition})` })
-      .from(checkins)
-      .where(
-        and(
-          eq(checkins.gameSetId, setId),
-          eq(checkins.isActive, true),
-          isNull(checkins.gameId)
-        )
-      );
-    
-    // Calculate the next queue position after the current highest overall
-    // This ensures we always have unique, sequential positions across all games
-    const nextQueuePosition = highestOverallPosition?.maxPosition 
-      ? (highestOverallPosition.maxPosition as number) + 1 
-      : 1; // Start at 1 if no positions used yet
-    
-    // Calculate next position for NEXT UP players
-    // If there are no NEXT UP players, this will start after the game players
-    const nextUpQueuePosition = highestNextUpPosition?.maxPosition 
-      ? (highestNextUpPosition.maxPosition as number) + 1 
-      : nextQueuePosition;
-    
-    console.log(`Game creation: Highest overall position ${highestOverallPosition?.maxPosition}, ` +
-      `highest NEXT UP position ${highestNextUpPosition?.maxPosition}, ` +
-      `setting currentQueuePosition to ${nextQueuePosition} and queueNextUp to ${nextUpQueuePosition}`);
+  // Reserve count queue ranks after every active checkin in the set, QUEUE_RANK_GAP apart, the way
+  // scootd does: the database's scoot_queue_allocate moves queueLastRank past them, respacing the
+  // set's ranks first if they would run past QUEUE_RANK_LIMIT
+  private async allocateQueueRanks(setId: number, count: number): Promise<number[]> {
+    const result = await db.execute<{ last_rank: number }>(
+      sql`SELECT public.scoot_queue_allocate(${setId}, ${count}) AS last_rank`
+    );
+    const lastRank = Number(result.rows[0]?.last_rank || 0);
+    if (lastRank === 0) {
+      throw new Error(`Game set ${setId} is not active`);
+    }
+    return Array.from({ length: count }, (_, i) => lastRank - (count - 1 - i) * QUEUE_RANK_GAP);
+  }
+
+  // Ranks for count players placed, in order, after everyone in a game and ahead of the first NEXT UP
+  // player. Only the new rows are written; the set's ranks are respaced when there is no room left
+  // between those two neighbours.
+  private async promotionQueueRanks(setId: number, count: number): Promise<number[]> {
+    for (let attempt = 0; attempt < 2; attempt++) {
+      const [firstWaiting] = await db
+        .select({ rank: sql<number | null>`MIN(${checkins.queuePosition})` })
+        .from(checkins)
+        .where(and(eq(checkins.gameSetId, setId), eq(checkins.isActive, true), isNull(checkins.gameId)));
+      if (firstWaiting?.rank == null) {
+        return this.allocateQueueRanks(setId, count);
+      }
+      const nextRank = Number(firstWaiting.rank);
 
-    // Update the game set's queue position trackers
+      const [lastAhead] = await db
+        .select({ rank: sql<number | null>`MAX(${checkins.queuePosition})` })
+        .from(checkins)
+        .where(and(eq(checkins.gameSetId, setId), eq(checkins.isActive, true), lt(checkins.queuePosition, nextRank)));
+      const previousRank = lastAhead?.rank != null ? Number(lastAhead.rank) : nextRank - (count + 1) * QUEUE_RANK_GAP;
+
+      const step = Math.floor((nextRank - previousRank) / (count + 1));
+      if (step > 0 && previousRank >= -QUEUE_RANK_LIMIT) {
+        return Array.from({ length: count }, (_, i) => previousRank + (i + 1) * step);
+      }
+      await db.execute(sql`SELECT public.scoot_queue_respace(${setId})`);
+    }
+    throw new Error(`Game set ${setId} has no room for ${count} more queue ranks`);
+  }
+
+  // Number the set's queue from departed positions further on, for checkins that left its front, and
+  // point queueNextUp at the position the next checkin will be shown at, as scootd keeps them
+  private async updateQueueTrackers(setId: number, departed: number): Promise<void> {
     await db
       .update(gameSets)
       .set({
-        // currentQueuePosition tracks the next position to be used
-        currentQueuePosition: nextQueuePosition,
-        // queueNextUp tracks the next position for NEXT UP players
-        queueNextUp: nextUpQueuePosition
+        currentQueuePosition: sql`${gameSets.currentQueuePosition} + ${departed}`,
+        queueNextUp: sql`${gameSets.currentQueuePosition} + ${departed} + (SELECT COUNT(*) FROM ${checkins} WHERE ${checkins.gameSetId} = ${setId} AND ${checkins.isActive})`
       })
       .where(eq(gameSets.id, setId));
-      
-    // Then create the game
+  }
+
+  async createGame(setId: number, court: string, state: string): Promise<Game> {
+    const [gameSet] = await db.select().from(gameSets).where(eq(gameSets.id, setId));
+    if (!gameSet) throw new Error(`Game set ${setId} not found`);
+    
+    // The players keep their active checkins and ranks while they play, so the queue's numbering
+    // stays as it is until updateGameScore takes them out of it
     const [game] = await db
       .insert(games)
       .values({
@@ -253,58 +244,6 @@ export class DatabaseStorage implements IStorage {
       throw new Error("No active game set found");
     }
     
-    // Count completed games for this game set to determine the correct queue positions
-    const [completedGamesCount] = await db
-      .select({ count: sql`COUNT(*)` })
-      .from(games)
-      .where(
-        and(
-          eq(games.setId, activeGameSet.id),
-          eq(games.state, 'final') // Count only finished games
-        )
-      );
-    
-    // Calculate what the queue positions should be based on number of completed games
-    // After first game: currentQueuePosition = playersPerTeam * 2 + 1 (9 for 4 players per team)
-    // After second game: currentQueuePosition = playersPerTeam * 2 * 2 + 1 (17 for 4 players per team)
-    // Formula: playersPerTeam * 2 * number_of_games + 1
-    
-    // Get count of completed games after this one
-    // Note: completedGamesCount gives games already marked as final
-    // but since the current game is in transition to final, we need to add 1
-    const countResult = Number(completedGamesCount?.count || 0);
-    const gamesCompleted = countResult + 1;
-    
-    // CRITICAL: correctQueuePosition MUST increment after each game by (playersPerTeam * 2)
-    // For 4 players per team:
-    // - After game 1: 9 (4*2*1 + 1)
-    // - After game 2: 17 (4*2*2 + 1)
-    // - After game 3: 25 (4*2*3 + 1)
-    const correctQueuePosition = (activeGameSet.playersPerTeam * 2 * gamesCompleted) + 1;
-    
-    console.log(`UPDATING QUEUE POSITION: Games completed (including this one): ${gamesCompleted}`);
-    console.log(`Setting currentQueuePosition to ${correctQueuePosition} (formula: ${activeGameSet.playersPerTeam}*2*${gamesCompleted}+1)`);
-    
-    
-    console.log('Queue position calculation:', {
-      playersPerTeam: activeGameSet.playersPerTeam,
-      gamesCompleted,
-      formula: `(${activeGameSet.playersPerTeam} * 2 * ${gamesCompleted}) + 1 = ${correctQueuePosition}`
-    });
-    const correctNextUpPosition = correctQueuePosition + (activeGameSet.playersPerTeam * 2);
-    
-    console.log(`Game ${gameId} finished. Total games completed: ${gamesCompleted}.`);
-    console.log(`Setting current_queue_position to ${correctQueuePosition} and queue_next_up to ${correctNextUpPosition}`);
-    
-    // Update the game set with corrected queue positions
-    await db
-      .update(gameSets)
-      .set({ 
-        currentQueuePosition: correctQueuePosition,
-        queueNextUp: correctNextUpPosition
-      })
-      .where(eq(gameSets.id, activeGameSet.id));
-
     // Log all active checkins before update
     const activeCheckins = await db
       .select({
@@ -344,11 +283,30 @@ export class DatabaseStorage implements IStorage {
       .from(gamePlayers)
       .where(eq(gamePlayers.gameId, gameId));
 
+    // Deactivate all of this game's checkins first; promoted and auto-up players come back to the queue
+    // as new checkins below. Each keeps the position it was shown at, and the set's numbering moves past
+    // them so the players still queued keep theirs.
+    const departed = await db
+      .update(checkins)
+      .set({
+        isActive: false,
+        queuePosition: sql`(SELECT ${queueEntries.queuePosition} FROM ${queueEntries} WHERE ${queueEntries.id} = ${checkins.id})`
+      })
+      .where(
+        and(
+          eq(checkins.gameId, gameId),
+          eq(checkins.isActive, true)
+        )
+      )
+      .returning({ id: checkins.id });
+      
+    console.log(`Deactivated ${departed.length} checkins for game ${gameId}`);
+
     // Initialize promotedPlayers outside the if block
     let promotedPlayers: { userId: number; team: number }[] = [];
 
     if (promotionInfo) {
-      // Get players from the promoted team along with their current queue positions
+      // Get players from the promoted team along with their queue ranks
       // We need to preserve their relative order
       const promotedPlayersResult = await db
         .select({
@@ -381,71 +339,11 @@ export class DatabaseStorage implements IStorage {
       
       // Log the order of promotion
       console.log('Promoting players in this order:', 
-        promotedPlayersResult.map(p => `${p.username} (Pos: ${p.queuePosition || 'N/A'})`)
+        promotedPlayersResult.map(p => `${p.username} (Rank: ${p.queuePosition ?? 'N/A'})`)
       );
 
       console.log('Found promoted players:', promotedPlayers.map(p => p.userId));
 
-      // Find ALL active checkins to determine the highest queue position
-      // We need a complete sequence of positions without gaps
-      const [highestOverallPosition] = await db
-        .select({ maxPosition: sql`MAX(${checkins.queuePosition})` })
-        .from(checkins)
-        .where(
-          and(
-            eq(checkins.isActive, true),
-            eq(checkins.gameSetId, activeGameSet.id)
-          )
-        );
-      
-      // Find the lowest position in the NEXT UP players 
-      // This tells us where the NEXT UP queue starts
-      const nextUpPlayers = await db
-        .select({
-          queuePosition: checkins.queuePosition
-        })
-        .from(checkins)
-        .where(
-          and(
-            eq(checkins.isActive, true),
-            eq(checkins.gameSetId, activeGameSet.id),
-            isNull(checkins.gameId) // Only NEXT UP players
-          )
-        )
-        .orderBy(asc(checkins.queuePosition));
-        
-      // Calculate the base position for promoted players
-      let baseQueuePosition;
-      if (nextUpPlayers.length > 0) {
-        // Get the lowest NEXT UP position - we'll insert at this position 
-        // and push existing players up
-        baseQueuePosition = nextUpPlayers[0].queuePosition;
-      } else {
-        // No NEXT UP players, insert right after HOME/AWAY team positions
-        baseQueuePosition = (activeGameSet.playersPerTeam * 2) + 1; // Position 9
-      }
-      
-      console.log(`Promotion: Found highest overall position ${highestOverallPosition?.maxPosition}, ` + 
-        `and ${nextUpPlayers.length} NEXT UP players starting at position ${nextUpPlayers.length > 0 ? nextUpPlayers[0].queuePosition : 'N/A'}. ` +
-        `Will insert promoted players at position ${baseQueuePosition}.`);
-      
-      // First make room by incrementing queue positions for affected waiting players
-      if (nextUpPlayers.length > 0) {
-        await db
-          .update(checkins)
-          .set({
-            queuePosition: sql`${checkins.queuePosition} + ${promotedPlayers.length}`
-          })
-          .where(
-            and(
-              eq(checkins.isActive, true),
-              eq(checkins.gameSetId, activeGameSet.id),
-              isNull(checkins.gameId), // Only update NEXT UP players
-              sql`${checkins.queuePosition} >= ${baseQueuePosition}` // Only update positions at or after insert point
-            )
-          );
-      }
-
       // Before creating new checkins, deactivate any existing active checkins for these promoted players
       // De-duplicate by deactivating ALL existing active checkins in the NEXT UP queue 
       // for these players, not just their most recent ones
@@ -508,64 +406,31 @@ export class DatabaseStorage implements IStorage {
         }
       }
       
-      // Then create new checkins for promoted team players at sequential positions
-      for (let i = 0; i < promotedPlayers.length; i++) {
-        const player = promotedPlayers[i];
-        await db
-          .insert(checkins)
-          .values({
-            userId: player.userId,
-            clubIndex: game.clubIndex || 34,
-            checkInTime: getCentralTime(),
-            isActive: true, // Always set isActive=true for players in the queue
-            checkInDate: getDateString(getCentralTime()),
-            gameSetId: activeGameSet.id,
-            queuePosition: baseQueuePosition + i, // Sequential positions
-            type: promotionInfo.type,
-            gameId: null,
-            team: player.team
-          });
-        
-        console.log(`Created checkin for promoted player ${player.userId} at position ${baseQueuePosition + i}`);
+      // Then create new checkins for promoted team players, in order, ahead of the NEXT UP list
+      if (promotedPlayers.length > 0) {
+        const ranks = await this.promotionQueueRanks(activeGameSet.id, promotedPlayers.length);
+        for (let i = 0; i < promotedPlayers.length; i++) {
+          const player = promotedPlayers[i];
+          await db
+            .insert(checkins)
+            .values({
+              userId: player.userId,
+              clubIndex: game.clubIndex || 34,
+              checkInTime: getCentralTime(),
+              isActive: true, // Always set isActive=true for players in the queue
+              checkInDate: getDateString(getCentralTime()),
+              gameSetId: activeGameSet.id,
+              queuePosition: ranks[i],
+              type: promotionInfo.type,
+              gameId: null,
+              team: player.team
+            });
+          
+          console.log(`Created checkin for promoted player ${player.userId} at queue rank ${ranks[i]}`);
+        }
       }
     }
 
-    // Deactivate ONLY the checkins for this game that were not promoted
-    // For promoted players, we should NOT deactivate their checkins as they need to remain active
-    const promotedUserIds = promotedPlayers.map(p => p.userId);
-    
-    // Deactivate only checkins for this game where user is not in promotedPlayers list
-    if (promotionInfo) {
-      // If we have promotion info, only deactivate non-promoted players
-      if (promotedUserIds.length > 0) {
-        // Use notInArray to get "NOT IN" behavior
-        await db
-          .update(checkins)
-          .set({ isActive: false })
-          .where(
-            and(
-              eq(checkins.gameId, gameId),
-              // User is not in the promoted players list - avoid direct SQL with params
-              notInArray(checkins.userId, promotedUserIds)
-            )
-          );
-      } else {
-        // No promoted players, so deactivate all for this game
-        await db
-          .update(checkins)
-          .set({ isActive: false })
-          .where(eq(checkins.gameId, gameId));
-      }
-    } else {
-      // No players were promoted, so deactivate all players for this game
-      await db
-        .update(checkins)
-        .set({ isActive: false })
-        .where(eq(checkins.gameId, gameId));
-    }
-      
-    console.log(`Deactivated non-promoted checkins for game ${gameId}`);
-      
     // Get all auto-up eligible players and create new active checkins for them
     console.log('Finding auto-up players:', {
       gamePlayerIds: gamePlayerIds.map(p => p.userId),
@@ -610,8 +475,7 @@ export class DatabaseStorage implements IStorage {
           .where(
             and(
               inArray(checkins.userId, autoUpUsersBase.map(u => u.id)),
-              eq(checkins.gameId, gameId),
-              eq(checkins.isActive, true)
+              eq(checkins.gameId, gameId)
             )
           )
           .orderBy(asc(checkins.queuePosition));
@@ -637,38 +501,14 @@ export class DatabaseStorage implements IStorage {
         console.log('Auto-up users found:', autoUpUsers.map(u => u.username));
         
         if (autoUpUsers.length > 0) {
-          // Find the highest queue position for active players in the NEXT UP list
-          const [highestPosition] = await db
-            .select({ maxPosition: sql`MAX(${checkins.queuePosition})` })
-            .from(checkins)
-            .where(
-              and(
-                eq(checkins.isActive, true),
-                isNull(checkins.gameId), // Only consider NEXT UP players
-                eq(checkins.gameSetId, activeGameSet.id)
-              )
-            );
-          
-          // Use highest position + 1 for consecutive positions, or default to position 9 if no NEXT UP players
-          // This ensures players are always added to the tail of the queue in consecutive positions
-          let nextPosition = highestPosition?.maxPosition 
-            ? (highestPosition.maxPosition as number) + 1 
-            : (activeGameSet.playersPerTeam * 2) + 1; // Default to position 9 if no NEXT UP players
+          // Auto-up players go to the tail of the queue, in the order they had
+          const ranks = await this.allocateQueueRanks(activeGameSet.id, autoUpUsers.length);
           
-          console.log(`Auto-recheckin: found highest queue position ${highestPosition?.maxPosition}, inserting auto-up players at ${nextPosition}`);
-          
-          // Update the queueNextUp in the game set to track the tail of the queue
-          await db
-            .update(gameSets)
-            .set({ 
-              queueNextUp: nextPosition + autoUpUsers.length
-              // We don't update currentQueuePosition here, it should remain at position 9 for NEXT_UP queue
-              // currentQueuePosition should only be incremented when creating a new game, not when finishing a game
-            })
-            .where(eq(gameSets.id, activeGameSet.id));
+          console.log(`Auto-recheckin: inserting auto-up players at queue ranks ${ranks[0]}-${ranks[ranks.length - 1]}`);
           
           // Create new checkins for autoup users
-          for (const user of autoUpUsers) {
+          for (let i = 0; i < autoUpUsers.length; i++) {
+            const user = autoUpUsers[i];
             await db
               .insert(checkins)
               .values({
@@ -678,18 +518,20 @@ export class DatabaseStorage implements IStorage {
                 isActive: true,
                 checkInDate: getDateString(getCentralTime()),
                 gameSetId: activeGameSet.id,
-                queuePosition: nextPosition++,
+                queuePosition: ranks[i],
                 type: CheckinType.AUTOUP,
                 gameId: null,
                 team: null
               });
             
-            console.log(`Auto-recheckin created for user ${user.username} at queue position ${nextPosition - 1}`);
+            console.log(`Auto-recheckin created for user ${user.username} at queue rank ${ranks[i]}`);
           }
         }
       }
     }
     
+    await this.updateQueueTrackers(activeGameSet.id, departed.length);
+    
     console.log(`Game ${gameId} updated successfully:`, updatedGame);
     return updatedGame;
   }
@@ -791,7 +633,8 @@ export class DatabaseStorage implements IStorage {
         // removed insertTime as it's not in the schema
         username: users.username,
         birthYear: users.birthYear,
-        queuePosition: checkins.queuePosition
+        // Shown position while the checkin is active; once the game is over, the one it was shown at
+        queuePosition: sql<number | null>`COALESCE(${queueEntries.queuePosition}, ${checkins.queuePosition})`
       })
       .from(gamePlayers)
       .innerJoin(users, eq(gamePlayers.userId, users.id))
@@ -801,8 +644,9 @@ export class DatabaseStorage implements IStorage {
           eq(checkins.gameId, gameId)
         )
       )
+      .leftJoin(queueEntries, eq(queueEntries.id, checkins.id))
       .where(eq(gamePlayers.gameId, gameId))
-      .orderBy(asc(checkins.queuePosition));
+      .orderBy(sql`COALESCE(${queueEntries.queuePosition}, ${checkins.queuePosition})`);
     
     // Make sure all players have a queue position (even if null in database)
     // For ones that have null queue positions, assign them based on team
@@ -1017,28 +861,13 @@ export class DatabaseStorage implements IStorage {
     // If user already has an active checkin in this game set, return it
     if (existingCheckins.length > 0) {
       console.log(`User ${userId} already has an active checkin in this game set:`, existingCheckins[0]);
-      return existingCheckins[0];
+      return this.withShownPosition(existingCheckins[0]);
     }
 
-    // Calculate the next available queue position for this checkin
-    // Find the highest position already in use (excluding this user)
-    const [highestPosition] = await db
-      .select({ maxPosition: sql`MAX(${checkins.queuePosition})` })
-      .from(checkins)
-      .where(
-        and(
-          eq(checkins.gameSetId, activeGameSet.id),
-          eq(checkins.isActive, true)
-        )
-      );
+    // Take the next queue rank after everyone already checked in
+    const [rank] = await this.allocateQueueRanks(activeGameSet.id, 1);
     
-    // If we're checking in the first player, use position 1
-    // Otherwise, use the highest used position + 1
-    const nextPosition = highestPosition?.maxPosition 
-      ? (highestPosition.maxPosition as number) + 1 
-      : 1;
-    
-    console.log(`Creating new checkin for user ${userId} with position ${nextPosition}`);
+    console.log(`Creating new checkin for user ${userId} with queue rank ${rank}`);
     const [checkin] = await db
       .insert(checkins)
       .values({
@@ -1048,7 +877,7 @@ export class DatabaseStorage implements IStorage {
         isActive: true,
         checkInDate: today,
         gameSetId: activeGameSet.id,
-        queuePosition: nextPosition,
+        queuePosition: rank,
         type: 'manual',
         gameId: null,
         team: null
@@ -1056,16 +885,18 @@ export class DatabaseStorage implements IStorage {
       .returning();
 
     // Update the game set's queueNextUp to track the tail position
-    // For fast reset, we want to make sure currentQueuePosition starts at 1
-    await db
-      .update(gameSets)
-      .set({ 
-        currentQueuePosition: 1, // FAST RESET: Always reset to 1 for new games
-        queueNextUp: nextPosition + 1  // This tracks the next available position
-      })
-      .where(eq(gameSets.id, activeGameSet.id));
+    await this.updateQueueTrackers(activeGameSet.id, 0);
+
+    return this.withShownPosition(checkin);
+  }
 
-    return checkin;
+  // An active checkin with the position queue_entries shows for it in place of its rank
+  private async withShownPosition(checkin: Checkin): Promise<Checkin> {
+    const [entry] = await db
+      .select({ queuePosition: queueEntries.queuePosition })
+      .from(queueEntries)
+      .where(and(eq(queueEntries.gameSetId, checkin.gameSetId), eq(queueEntries.id, checkin.id)));
+    return { ...checkin, queuePosition: entry?.queuePosition ?? checkin.queuePosition };
   }
 
   async deactivatePlayerCheckin(userId: number): Promise<void> {
@@ -1091,35 +922,6 @@ export class DatabaseStorage implements IStorage {
       throw new Error("No active game set available");
     }
     
-    // FIRST: Fix any incorrect currentQueuePosition values in the active game set
-    // This ensures our formula fix takes effect immediately without waiting for the next game to finish
-    if (state.activeGameSet.currentQueuePosition > 50) { // Likely using the wrong formula if > 50
-      // Count completed games to determine the correct position
-      const completedGamesResult = await db
-        .select({ count: sql`COUNT(*)` })
-        .from(games)
-        .where(
-          and(
-            eq(games.setId, state.activeGameSet.id),
-            eq(games.state, 'final')
-          )
-        );
-      
-      // Safely extract the count from the result
-      const countValue = completedGamesResult[0]?.count;
-      const gamesFinished = Number(countValue || 0);
-      // Apply the corrected formula
-      const correctQueuePosition = (state.activeGameSet.playersPerTeam * 2 * gamesFinished) + 1;
-      
-      console.log(`Correcting queue position from ${state.activeGameSet.currentQueuePosition} to ${correctQueuePosition} based on ${gamesFinished} finished games`);
-      
-      // Update the game set with the correct queue position
-      await db
-        .update(gameSets)
-        .set({ currentQueuePosition: correctQueuePosition })
-        .where(eq(gameSets.id, state.activeGameSet.id));
-    }
-    
     // Make sure all loss_promoted and win_promoted players are marked isActive=true
     // This fixes the issue where they don't show up in the NEXT_UP list
     await db
@@ -1509,32 +1311,14 @@ export class DatabaseStorage implements IStorage {
     currentCheckin: { id: number; queuePosition: number; username: string },
     activeGameSet: GameSet
   ): Promise<void> {
-    // For NEXT UP player checkout:
-    // 1. Set the player as inactive
-    // 2. Find all players after this one in the queue
-    // 3. Move each player up one position
-    
-    const state = await this.getCurrentCheckinsState();
-    const playersAfterCurrent = state.nextUpPlayers.filter(p => p.queuePosition > currentCheckin.queuePosition);
-    
-    // Transaction to ensure atomicity
-    await db.transaction(async tx => {
-      // Deactivate the current player's check-in
-      await tx
-        .update(checkins)
-        .set({ isActive: false })
-        .where(eq(checkins.id, currentCheckin.id));
-      
-      // Move each subsequent player up one position
-      for (const player of playersAfterCurrent) {
-        await tx
-          .update(checkins)
-          .set({ queuePosition: player.queuePosition - 1 })
-          .where(eq(checkins.id, player.id));
-      }
-    });
+    // For NEXT UP player checkout, set the player as inactive. The players after them keep their
+    // ranks; queue_entries shows each of them one position further up.
+    await db
+      .update(checkins)
+      .set({ isActive: false })
+      .where(eq(checkins.id, currentCheckin.id));
     
-    console.log(`NEXT UP checkout: ${currentCheckin.username} checked out, ${playersAfterCurrent.length} players moved up`);
+    console.log(`NEXT UP checkout: ${currentCheckin.username} checked out`);
   }
 
   // Method to handle game player checkout by admin
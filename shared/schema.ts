@@ -1,4 +1,5 @@
-import { pgTable, text, serial, integer, boolean, timestamp, json } from "drizzle-orm/pg-core";
+import { pgTable, pgView, text, serial, integer, boolean, timestamp, json, primaryKey, bigint, index } from "drizzle-orm/pg-core";
+import { sql } from "drizzle-orm";
 import { createInsertSchema } from "drizzle-zod";
 import { z } from "zod";
 
@@ -51,10 +52,24 @@ export const gameSets = pgTable("game_sets", {
   numberOfCourts: integer("number_of_courts").notNull().default(2),
   currentQueuePosition: integer("current_queue_position").notNull().default(1),
   queueNextUp: integer("queue_next_up").notNull().default(1),
+  version: integer("version").notNull().default(0),  // Bumped by database triggers on every change to the set
+  queueLastRank: integer("queue_last_rank").notNull().default(0),  // Last queue rank handed out by scootd
 });
 
+// Which users' queue entries and which games changed at each game set version (kept by database triggers)
+export const gameSetChanges = pgTable("game_set_changes", {
+  gameSetId: integer("game_set_id").notNull(),
+  version: integer("version").notNull(),
+  userId: integer("user_id"),
+  gameId: integer("game_id"),
+}, (table) => ({
+  pk: primaryKey({ columns: [table.gameSetId, table.version] }),
+}));
+
+// Range-partitioned by month on startTime (see schema.sql and `scootd maintain-partitions`); each
+// partition holds its own primary key
 export const games = pgTable("games", {
-  id: serial("id").primaryKey(),
+  id: serial("id").notNull(),
   setId: integer("set_id").notNull(),
   startTime: timestamp("start_time").notNull(),
   endTime: timestamp("end_time"),
@@ -63,10 +78,77 @@ export const games = pgTable("games", {
   clubIndex: integer("club_index").notNull().default(34),
   court: text("court").notNull(),
   state: text("state").notNull().default('started'),
+  winningTeam: integer("winning_team"),
+  // Team fingerprints written by scootd new-game: sorted player ids and their 64-bit hash
+  team1Key: text("team1_key"),
+  team1Hash: bigint("team1_hash", { mode: "number" }),
+  team2Key: text("team2_key"),
+  team2Hash: bigint("team2_hash", { mode: "number" }),
+}, (table) => ({
+  team1HashIdx: index("games_set_team1_hash_idx").on(table.setId, table.team1Hash),
+  team2HashIdx: index("games_set_team2_hash_idx").on(table.setId, table.team2Hash),
+  // Per-set lookups: active games and courts, and the most recently completed games
+  setStateCourtIdx: index("games_set_state_court_idx").on(table.setId, table.state, table.court),
+  setCompletedIdx: index("games_set_completed_idx").on(table.setId, table.endTime.desc(), table.id.desc()).where(sql`${table.state} = 'completed'`),
+}));
+
+// Games played by each team (players' ids in order) in a game set, counted by scootd end-game
+export const teamStreaks = pgTable("team_streaks", {
+  gameSetId: integer("game_set_id").notNull(),
+  teamKey: text("team_key").notNull(),
+  gamesPlayed: integer("games_played").notNull().default(0),
+}, (table) => ({
+  pk: primaryKey({ columns: [table.gameSetId, table.teamKey] }),
+}));
+
+// Career totals over completed games, added to by scootd end-game and recomputed by `scootd rebuild-stats`;
+// streaks count consecutive wins
+export const playerStats = pgTable("player_stats", {
+  userId: integer("user_id").primaryKey(),
+  gamesPlayed: integer("games_played").notNull().default(0),
+  wins: integer("wins").notNull().default(0),
+  losses: integer("losses").notNull().default(0),
+  currentStreak: integer("current_streak").notNull().default(0),
+  bestStreak: integer("best_streak").notNull().default(0),
+  pointsFor: integer("points_for").notNull().default(0),
+  pointsAgainst: integer("points_against").notNull().default(0),
+  lastPlayedAt: timestamp("last_played_at"),
+}, (table) => ({
+  // Season leaderboards read by `scootd leaderboard season`
+  winsIdx: index("player_stats_wins_idx").on(table.wins.desc(), table.gamesPlayed.desc(), table.userId),
+  winPctIdx: index("player_stats_win_pct_idx").on(sql`(${table.wins}::numeric / NULLIF(${table.gamesPlayed}, 0)) DESC NULLS LAST`, table.gamesPlayed.desc(), table.userId),
+  streakIdx: index("player_stats_streak_idx").on(table.currentStreak.desc(), table.gamesPlayed.desc(), table.userId),
+  bestStreakIdx: index("player_stats_best_streak_idx").on(table.bestStreak.desc(), table.gamesPlayed.desc(), table.userId),
+  gamesIdx: index("player_stats_games_idx").on(table.gamesPlayed.desc(), table.userId),
+}));
+
+// player_stats for the games of one game set, read by `scootd leaderboard <game_set_id>`
+export const gameSetPlayerStats = pgTable("game_set_player_stats", {
+  gameSetId: integer("game_set_id").notNull(),
+  userId: integer("user_id").notNull(),
+  gamesPlayed: integer("games_played").notNull().default(0),
+  wins: integer("wins").notNull().default(0),
+  losses: integer("losses").notNull().default(0),
+  currentStreak: integer("current_streak").notNull().default(0),
+  bestStreak: integer("best_streak").notNull().default(0),
+  pointsFor: integer("points_for").notNull().default(0),
+  pointsAgainst: integer("points_against").notNull().default(0),
+  lastPlayedAt: timestamp("last_played_at"),
+}, (table) => ({
+  pk: primaryKey({ columns: [table.gameSetId, table.userId] }),
+}));
+
+// Schema migrations applied by `scootd migrate`
+export const scootSchemaMigrations = pgTable("scoot_schema_migrations", {
+  version: integer("version").primaryKey(),
+  name: text("name").notNull(),
+  appliedAt: timestamp("applied_at").notNull().defaultNow(),
 });
 
+// Partitioned on isActive (see schema.sql): queue rows live in checkins_active and deactivated ones in
+// checkins_history, which also hold the primary keys and the queue indexes
 export const checkins = pgTable("checkins", {
-  id: serial("id").primaryKey(),
+  id: serial("id").notNull(),
   userId: integer("user_id").notNull(),
   gameSetId: integer("game_set_id").notNull(),
   queuePosition: integer("queue_position").notNull(),
@@ -77,14 +159,38 @@ export const checkins = pgTable("checkins", {
   gameId: integer("game_id"),
   type: text("type").notNull().default('manual'),
   team: integer("team"),  // New column: team number (1 or 2, or null if not assigned)
-});
+}, (table) => ({
+  gameUserIdx: index("checkins_game_user_idx").on(table.gameId, table.userId).where(sql`${table.gameId} IS NOT NULL`),
+}));
+
+// Active checkins keep a sparse rank in queue_position, QUEUE_RANK_GAP apart when handed out, so a move
+// writes only the moved rows; this view (see schema.sql) numbers them from currentQueuePosition in rank order
+export const QUEUE_RANK_GAP = 1024;
+export const QUEUE_RANK_LIMIT = 2 ** 30;  // The set's ranks are respaced before one would pass it
+
+export const queueEntries = pgView("queue_entries", {
+  id: integer("id").notNull(),
+  userId: integer("user_id").notNull(),
+  gameSetId: integer("game_set_id").notNull(),
+  gameId: integer("game_id"),
+  type: text("type").notNull(),
+  team: integer("team"),
+  queueRank: integer("queue_rank").notNull(),
+  queuePosition: integer("queue_position").notNull(),  // The position shown for the entry
+}).existing();
 
+// Range-partitioned by month on gameStartTime, like games
 export const gamePlayers = pgTable("game_players", {
-  id: serial("id").primaryKey(),
+  id: serial("id").notNull(),
   gameId: integer("game_id").notNull(),
   userId: integer("user_id").notNull(),
   team: integer("team").notNull(),
-});
+  relativePosition: integer("relative_position"),
+  gameStartTime: timestamp("game_start_time").notNull().defaultNow(),  // Copy of games.start_time to partition on
+}, (table) => ({
+  gameTeamIdx: index("game_players_game_team_idx").on(table.gameId, table.team, table.relativePosition),
+  userIdx: index("game_players_user_idx").on(table.userId),
+}));
 
 // Chat message table for Scoot(1995)
 export const messages = pgTable("messages", {
@@ -0,0 +1,118 @@
+/*
+ * Checks for the queue ranks end-game gives the players it puts back, at and just past
+ * SCOOT_RANK_LIMIT, and for the ranks a respaced queue starts from. scootd.c is compiled in whole
+ * so the static helpers are tested as shipped; its main() is renamed out of the way.
+ *
+ *   make test
+ */
+#define main scootd_main
+#include "scootd.c"
+#undef main
+
+static int tests_run = 0;
+static int tests_passed = 0;
+
+static void check(const char *name, bool ok) {
+    tests_run++;
+    printf("Test %d: %s\n", tests_run, name);
+    if (ok) {
+        printf("  ✓ PASS\n");
+        tests_passed++;
+    } else {
+        printf("  ✗ FAIL\n");
+    }
+}
+
+/**
+ * True when ranks holds promoted ranks below first_rank and then autoup ranks above last_rank,
+ * strictly increasing and within the limit
+ */
+static bool ranks_placed(const int ranks[], int promoted, int autoup, int first_rank, int last_rank) {
+    for (int i = 0; i < promoted + autoup; i++) {
+        if (ranks[i] < -SCOOT_RANK_LIMIT || ranks[i] > SCOOT_RANK_LIMIT) {
+            return false;
+        }
+        if (i > 0 && ranks[i] <= ranks[i - 1]) {
+            return false;
+        }
+        if (i < promoted ? ranks[i] >= first_rank : ranks[i] <= last_rank) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void test_requeue_ranks(void) {
+    int ranks[PLAYERS_PER_TEAM * 4];
+    
+    bool ok = scoot_requeue_ranks(SCOOT_RANK_GAP, 8 * SCOOT_RANK_GAP, 4, 2, ranks);
+    check("promoted just ahead of the queue, autoup just after it",
+          ok && ranks[0] == -3 * SCOOT_RANK_GAP && ranks[3] == 0 &&
+          ranks[4] == 9 * SCOOT_RANK_GAP && ranks[5] == 10 * SCOOT_RANK_GAP &&
+          ranks_placed(ranks, 4, 2, SCOOT_RANK_GAP, 8 * SCOOT_RANK_GAP));
+    
+    check("no players to put back", scoot_requeue_ranks(0, 0, 0, 0, ranks));
+    
+    int last_rank = SCOOT_RANK_LIMIT - 2 * SCOOT_RANK_GAP;
+    ok = scoot_requeue_ranks(SCOOT_RANK_GAP, last_rank, 0, 2, ranks);
+    check("autoup reaching exactly SCOOT_RANK_LIMIT fits", ok && ranks[1] == SCOOT_RANK_LIMIT);
+    check("autoup one past SCOOT_RANK_LIMIT needs a respace",
+          !scoot_requeue_ranks(SCOOT_RANK_GAP, last_rank + 1, 0, 2, ranks));
+    
+    int first_rank = -SCOOT_RANK_LIMIT + 4 * SCOOT_RANK_GAP;
+    ok = scoot_requeue_ranks(first_rank, SCOOT_RANK_GAP, 4, 0, ranks);
+    check("promoted reaching exactly -SCOOT_RANK_LIMIT fits", ok && ranks[0] == -SCOOT_RANK_LIMIT);
+    check("promoted one past -SCOOT_RANK_LIMIT needs a respace",
+          !scoot_requeue_ranks(first_rank - 1, SCOOT_RANK_GAP, 4, 0, ranks));
+    
+    check("either end past the limit needs a respace",
+          !scoot_requeue_ranks(first_rank, last_rank + 1, 4, 2, ranks) &&
+          !scoot_requeue_ranks(first_rank - 1, last_rank, 4, 2, ranks));
+    
+    check("a queue already at both limits takes no more",
+          !scoot_requeue_ranks(-SCOOT_RANK_LIMIT, SCOOT_RANK_LIMIT, 1, 0, ranks) &&
+          !scoot_requeue_ranks(-SCOOT_RANK_LIMIT, SCOOT_RANK_LIMIT, 0, 1, ranks));
+}
+
+static void test_respaced_bounds(void) {
+    int ranks[PLAYERS_PER_TEAM * 4];
+    int first_rank, last_rank;
+    
+    scoot_respaced_bounds(0, &first_rank, &last_rank);
+    check("an empty queue respaces to no ranks", first_rank == 0 && last_rank == 0);
+    
+    bool ok = scoot_requeue_ranks(first_rank, last_rank, PLAYERS_PER_TEAM * 2, PLAYERS_PER_TEAM * 2, ranks);
+    check("a full game fits around an empty respaced queue",
+          ok && ranks_placed(ranks, PLAYERS_PER_TEAM * 2, PLAYERS_PER_TEAM * 2, first_rank, last_rank));
+    
+    scoot_respaced_bounds(40, &first_rank, &last_rank);
+    check("a respaced queue starts one gap up and ends waiting gaps up",
+          first_rank == SCOOT_RANK_GAP && last_rank == 40 * SCOOT_RANK_GAP);
+    
+    // The case end-game respaces for: a queue whose ends had drifted to the limits
+    int waiting = 40;
+    ok = !scoot_requeue_ranks(-SCOOT_RANK_LIMIT + SCOOT_RANK_GAP, SCOOT_RANK_LIMIT, PLAYERS_PER_TEAM, 2, ranks);
+    scoot_respaced_bounds(waiting, &first_rank, &last_rank);
+    ok = ok && scoot_requeue_ranks(first_rank, last_rank, PLAYERS_PER_TEAM, 2, ranks);
+    check("a drifted queue fits again once respaced",
+          ok && ranks_placed(ranks, PLAYERS_PER_TEAM, 2, first_rank, last_rank));
+    
+    int most = SCOOT_RANK_LIMIT / SCOOT_RANK_GAP - PLAYERS_PER_TEAM * 2;
+    scoot_respaced_bounds(most, &first_rank, &last_rank);
+    ok = scoot_requeue_ranks(first_rank, last_rank, 0, PLAYERS_PER_TEAM * 2, ranks);
+    scoot_respaced_bounds(most + 1, &first_rank, &last_rank);
+    check("the longest respaced queue still takes a full team of autoup players",
+          ok && !scoot_requeue_ranks(first_rank, last_rank, 0, PLAYERS_PER_TEAM * 2, ranks));
+}
+
+int main() {
+    printf("QUEUE RANK TEST\n");
+    printf("===============\n\n");
+    
+    test_requeue_ranks();
+    test_respaced_bounds();
+    
+    printf("\nResults: %d/%d tests passed\n", tests_passed, tests_run);
+    
+    return tests_passed == tests_run ? 0 : 1;
+}
@@ -0,0 +1,255 @@
+/*
+ * Checks for the ScootDoc response writer: JSON escaping and layout, and the MessagePack
+ * encoding of each value and container size class. scootd.c is compiled in whole so the static
+ * writer is tested as shipped; its main() is renamed out of the way.
+ *
+ *   make test
+ */
+#define main scootd_main
+#include "scootd.c"
+#undef main
+
+static int tests_run = 0;
+static int tests_passed = 0;
+
+/**
+ * Compare a finished document with the bytes expected, printing both in hex when they differ
+ */
+static void check_bytes(const char *name, const ScootDoc *d, const char *expected, size_t expected_len) {
+    bool ok = !d->failed && d->depth == 0 && d->len == expected_len && memcmp(d->buf, expected, expected_len) == 0;
+    
+    tests_run++;
+    printf("Test %d: %s\n", tests_run, name);
+    if (ok) {
+        printf("  ✓ PASS\n");
+        tests_passed++;
+        return;
+    }
+    
+    printf("  Expected:");
+    for (size_t i = 0; i < expected_len; i++) {
+        printf(" %02x", (unsigned char)expected[i]);
+    }
+    printf("\n  Got:     ");
+    for (size_t i = 0; i < d->len; i++) {
+        printf(" %02x", (unsigned char)d->buf[i]);
+    }
+    printf("%s\n  ✗ FAIL\n", d->failed ? " (failed)" : "");
+}
+
+static void check_json(const char *name, const ScootDoc *d, const char *expected) {
+    check_bytes(name, d, expected, strlen(expected));
+}
+
+/* A JSON document holding a single string value */
+static void check_json_string(const char *name, const char *value, size_t len, const char *expected) {
+    ScootDoc d;
+    
+    scoot_doc_init(&d, SCOOT_DOC_JSON);
+    scoot_doc_string(&d, value, len);
+    check_json(name, &d, expected);
+}
+
+static void test_json_escaping(void) {
+    check_json_string("plain string", "abc", 3, "\"abc\"");
+    check_json_string("empty string", "", 0, "\"\"");
+    check_json_string("quotes and backslashes", "o'neil \"q\" \\", 12, "\"o'neil \\\"q\\\" \\\\\"");
+    check_json_string("escape at both ends", "\"mid\"", 5, "\"\\\"mid\\\"\"");
+    check_json_string("newline, return and tab", "a\nb\rc\td", 7, "\"a\\nb\\rc\\td\"");
+    check_json_string("other control characters", "\x01x\x1f", 3, "\"\\u0001x\\u001f\"");
+    check_json_string("embedded NUL", "a\0b", 3, "\"a\\u0000b\"");
+    check_json_string("UTF-8 passes through", "caf\xc3\xa9", 5, "\"caf\xc3\xa9\"");
+    check_json_string("DEL is not escaped", "\x7f", 1, "\"\x7f\"");
+}
+
+static void test_json_layout(void) {
+    ScootDoc d;
+    
+    scoot_doc_init(&d, SCOOT_DOC_JSON);
+    scoot_doc_object(&d);
+    scoot_doc_field_str(&d, "name", "a\"b");
+    scoot_doc_field_str(&d, "missing", NULL);
+    scoot_doc_key(&d, "rows");
+    scoot_doc_array(&d);
+    scoot_doc_row(&d);
+    scoot_doc_field_int(&d, "rank", 1);
+    scoot_doc_field_bool(&d, "ok", true);
+    scoot_doc_end(&d);
+    scoot_doc_end(&d);
+    scoot_doc_key(&d, "ids");
+    scoot_doc_list(&d);
+    scoot_doc_int(&d, 4);
+    scoot_doc_int(&d, -7);
+    scoot_doc_end(&d);
+    scoot_doc_key(&d, "win_pct");
+    scoot_doc_fixed(&d, 2.0 / 3.0, 3);
+    scoot_doc_end(&d);
+    check_json("nested object, rows and lists", &d,
+               "{\n"
+               "  \"name\": \"a\\\"b\",\n"
+               "  \"missing\": null,\n"
+               "  \"rows\": [\n"
+               "    { \"rank\": 1, \"ok\": true }\n"
+               "  ],\n"
+               "  \"ids\": [4, -7],\n"
+               "  \"win_pct\": 0.667\n"
+               "}\n");
+    
+    scoot_doc_init(&d, SCOOT_DOC_JSON);
+    scoot_doc_object(&d);
+    scoot_doc_key(&d, "queue");
+    scoot_doc_array(&d);
+    scoot_doc_end(&d);
+    scoot_doc_key(&d, "row");
+    scoot_doc_row(&d);
+    scoot_doc_end(&d);
+    scoot_doc_end(&d);
+    check_json("empty containers", &d, "{\n  \"queue\": [],\n  \"row\": {}\n}\n");
+    
+    scoot_doc_init(&d, SCOOT_DOC_JSON);
+    scoot_doc_object(&d);
+    scoot_doc_end(&d);
+    scoot_doc_end(&d);
+    tests_run++;
+    printf("Test %d: closing more containers than were opened fails\n", tests_run);
+    if (d.failed) {
+        printf("  ✓ PASS\n");
+        tests_passed++;
+    } else {
+        printf("  ✗ FAIL\n");
+    }
+}
+
+/* A MessagePack document holding a single int value */
+static void check_pack_int(long long value, const char *expected, size_t expected_len) {
+    ScootDoc d;
+    char name[64];
+    
+    scoot_doc_init(&d, SCOOT_DOC_MSGPACK);
+    scoot_doc_int(&d, value);
+    snprintf(name, sizeof(name), "int %lld", value);
+    check_bytes(name, &d, expected, expected_len);
+}
+
+static void test_msgpack_ints(void) {
+    check_pack_int(0, "\x00", 1);
+    check_pack_int(127, "\x7f", 1);
+    check_pack_int(128, "\xcc\x80", 2);
+    check_pack_int(255, "\xcc\xff", 2);
+    check_pack_int(256, "\xcd\x01\x00", 3);
+    check_pack_int(65535, "\xcd\xff\xff", 3);
+    check_pack_int(65536, "\xd2\x00\x01\x00\x00", 5);
+    check_pack_int(-1, "\xff", 1);
+    check_pack_int(-32, "\xe0", 1);
+    check_pack_int(-33, "\xd2\xff\xff\xff\xdf", 5);
+    check_pack_int(INT32_MIN, "\xd2\x80\x00\x00\x00", 5);
+    check_pack_int((long long)INT32_MAX + 1, "\xd3\x00\x00\x00\x00\x80\x00\x00\x00", 9);
+}
+
+/* A MessagePack string of len 'x' bytes: its header, then the bytes */
+static void check_pack_string(size_t len, const char *header, size_t header_len) {
+    ScootDoc d;
+    char name[64];
+    char *value = malloc(len + 1);
+    char *expected = malloc(header_len + len);
+    
+    memset(value, 'x', len);
+    value[len] = '\0';
+    memcpy(expected, header, header_len);
+    memset(expected + header_len, 'x', len);
+    
+    scoot_doc_init(&d, SCOOT_DOC_MSGPACK);
+    scoot_doc_str(&d, value);
+    snprintf(name, sizeof(name), "string of %zu bytes", len);
+    check_bytes(name, &d, expected, header_len + len);
+    
+    free(value);
+    free(expected);
+}
+
+static void test_msgpack_strings(void) {
+    check_pack_string(0, "\xa0", 1);
+    check_pack_string(31, "\xbf", 1);
+    check_pack_string(32, "\xd9\x20", 2);
+    check_pack_string(255, "\xd9\xff", 2);
+    check_pack_string(256, "\xda\x01\x00", 3);
+    check_pack_string(65536, "\xdb\x00\x01\x00\x00", 5);
+}
+
+static void test_msgpack_containers(void) {
+    ScootDoc d;
+    
+    scoot_doc_init(&d, SCOOT_DOC_MSGPACK);
+    scoot_doc_object(&d);
+    scoot_doc_key(&d, "a");
+    scoot_doc_list(&d);
+    scoot_doc_int(&d, 1);
+    scoot_doc_bool(&d, false);
+    scoot_doc_null(&d);
+    scoot_doc_end(&d);
+    scoot_doc_field_bool(&d, "b", true);
+    scoot_doc_key(&d, "c");
+    scoot_doc_fixed(&d, 0.5, 3);
+    scoot_doc_end(&d);
+    check_bytes("nested map and array narrowed to fix headers", &d,
+                "\x83\xa1" "a" "\x93\x01\xc2\xc0\xa1" "b" "\xc3\xa1" "c" "\xcb\x3f\xe0\x00\x00\x00\x00\x00\x00", 21);
+    
+    scoot_doc_init(&d, SCOOT_DOC_MSGPACK);
+    scoot_doc_array(&d);
+    scoot_doc_end(&d);
+    check_bytes("empty array", &d, "\x90", 1);
+    
+    // 15 elements still fit a fixarray, 16 need an array16 header
+    for (int n = 15; n <= 16; n++) {
+        char expected[3 + 16];
+        size_t header = n == 15 ? 1 : 3;
+        
+        scoot_doc_init(&d, SCOOT_DOC_MSGPACK);
+        scoot_doc_array(&d);
+        for (int i = 0; i < n; i++) {
+            scoot_doc_int(&d, i);
+        }
+        scoot_doc_end(&d);
+        
+        if (n == 15) {
+            expected[0] = (char)0x9f;
+        } else {
+            memcpy(expected, "\xdc\x00\x10", 3);
+        }
+        for (int i = 0; i < n; i++) {
+            expected[header + i] = (char)i;
+        }
+        check_bytes(n == 15 ? "array of 15 values" : "array of 16 values", &d, expected, header + n);
+    }
+    
+    // 65536 members need the map32 header the writer reserved up front
+    scoot_doc_init(&d, SCOOT_DOC_MSGPACK);
+    scoot_doc_row(&d);
+    for (int i = 0; i < 65536; i++) {
+        scoot_doc_field_int(&d, "", 0);
+    }
+    scoot_doc_end(&d);
+    tests_run++;
+    printf("Test %d: map of 65536 members keeps a map32 header\n", tests_run);
+    if (!d.failed && d.len == 5 + 65536 * 2 && memcmp(d.buf, "\xdf\x00\x01\x00\x00\xa0\x00", 7) == 0) {
+        printf("  ✓ PASS\n");
+        tests_passed++;
+    } else {
+        printf("  ✗ FAIL\n");
+    }
+}
+
+int main() {
+    printf("SCOOT DOC WRITER TEST\n");
+    printf("=====================\n\n");
+    
+    test_json_escaping();
+    test_json_layout();
+    test_msgpack_ints();
+    test_msgpack_strings();
+    test_msgpack_containers();
+    
+    printf("\nResults: %d/%d tests passed\n", tests_passed, tests_run);
+    
+    return tests_passed == tests_run ? 0 : 1;
+}